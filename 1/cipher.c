@@ -2,14 +2,21 @@
  * Cipher algorithm
  */
 
+#define _DEFAULT_SOURCE
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "libcipher.h"
 
 /**
  * @brief numbers of expected arguments in the program arguments for the
- * program to run properly
+ * program to run properly, options may follow them
  */
 #define NUM_ARGS 5
 /**
@@ -20,6 +27,49 @@
  * @brief a valid command given in program arguments
  */
 #define COMMAND_DECODE "decode"
+/**
+ * @brief command that finds the shift a file was encoded with and decodes it
+ */
+#define COMMAND_CRACK "crack"
+/**
+ * @brief numbers of expected arguments for the crack command, options may
+ * follow them
+ */
+#define CRACK_NUM_ARGS 4
+/**
+ * @brief index of input file in array of program args of the crack command
+ */
+#define CRACK_INPUT_FILE_PATH 2
+/**
+ * @brief index of output file in array of program args of the crack command
+ */
+#define CRACK_OUTPUT_FILE_PATH 3
+/**
+ * @brief message with the shift the crack command found
+ */
+#define CRACK_RESULT "The detected shift is %d\n"
+/**
+ * @brief command that decodes the source file with every shift at once
+ */
+#define COMMAND_BRUTE "brute"
+/**
+ * @brief numbers of expected arguments for the brute command, options may
+ * follow them
+ */
+#define BRUTE_NUM_ARGS 4
+/**
+ * @brief index of input file in array of program args of the brute command
+ */
+#define BRUTE_INPUT_FILE_PATH 2
+/**
+ * @brief index of the output prefix in array of program args of the brute
+ * command
+ */
+#define BRUTE_OUTPUT_PREFIX 3
+/**
+ * @brief line of a candidate of the brute command, its shift and its path
+ */
+#define BRUTE_RESULT "%d %s.%d\n"
 /**
  * @brief index of command in program args array
  */
@@ -28,7 +78,15 @@
  * @brief error if not correct numbers of arguments given
  */
 #define ERROR_ARGS "Usage: cipher <encode|decode> <k> <source path file> "\
-"<output path file>\n"
+"<output path file> [options]\n"\
+"       cipher crack <source path file> <output path file> [options]\n"\
+"       cipher brute <source path file> <output prefix> [--top <n>] "\
+"[options]\n"\
+"Options: [--block-size <bytes>] [--table] [--mmap] [--threads <n>] "\
+"[--batch] [--vigenere] [--uring]\n"\
+"         [--framed] [--frame-size <bytes>] [--range <offset> <length>]\n"\
+"         [--follow] [--watch] [--crc] [--crc-file <path>] [--utf8]\n"\
+"         [--daemon <socket path>] [--stats]\n"
 /**
  * @brief error if the command is invalid
  */
@@ -55,25 +113,158 @@
  */
 #define OUTPUT_FILE_PATH 4
 /**
- * @brief ascii number of 'a'
+ * @brief option to set the size of the blocks read and written at once
+ */
+#define OPTION_BLOCK_SIZE "--block-size"
+/**
+ * @brief option to transform through a precomputed translation table
+ */
+#define OPTION_TABLE "--table"
+/**
+ * @brief option to transform regular files through memory mappings
+ */
+#define OPTION_MMAP "--mmap"
+/**
+ * @brief option to overlap reading, transforming and writing the blocks of
+ * a regular file through io_uring
+ */
+#define OPTION_URING "--uring"
+/**
+ * @brief option to split a regular file between several worker threads
+ */
+#define OPTION_THREADS "--threads"
+/**
+ * @brief option to transform a batch of files - the source path is a
+ * directory or a manifest of input and output paths, the output path is the
+ * directory to put the outputs in
+ */
+#define OPTION_BATCH "--batch"
+/**
+ * @brief option to encode with a vigenere key word, given in place of k
+ */
+#define OPTION_VIGENERE "--vigenere"
+/**
+ * @brief option to encode into, or decode from, a framed file whose frames
+ * can be decoded in parallel and on their own
+ */
+#define OPTION_FRAMED "--framed"
+/**
+ * @brief option to set the number of input bytes in a frame
+ */
+#define OPTION_FRAME_SIZE "--frame-size"
+/**
+ * @brief option to decode only a range of a framed file, given as the offset
+ * and length in the decoded file
+ */
+#define OPTION_RANGE "--range"
+/**
+ * @brief option to transform only the bytes appended to the source file
+ * since the last run, and append them to the output file
+ */
+#define OPTION_FOLLOW "--follow"
+/**
+ * @brief option to keep following the source file as it grows
+ */
+#define OPTION_WATCH "--watch"
+/**
+ * @brief option to print the CRC32C of the source and the output file,
+ * computed in the same pass as the transform
+ */
+#define OPTION_CRC "--crc"
+/**
+ * @brief option to write the CRC32C lines to a sidecar file instead
+ */
+#define OPTION_CRC_FILE "--crc-file"
+/**
+ * @brief line of the CRC32C of a file and its path
+ */
+#define CRC_LINE "%08x  %s\n"
+/**
+ * @brief option to fail unless the source file is valid UTF-8
+ */
+#define OPTION_UTF8 "--utf8"
+/**
+ * @brief option to print the statistics line of the run to stderr
  */
-#define LOWER_CASE_MIN 97
+#define OPTION_STATS "--stats"
 /**
- * @brief ascii number of 'z'
+ * @brief statistics line of a run - the bytes and blocks transformed, the
+ * average block, the wall, user and system seconds, the MB/s over the wall
+ * time, and the read and write system calls, "-" where unknown
  */
-#define LOWER_CASE_MAX 122
+#define STATS_LINE "stats bytes=%llu blocks=%llu avg_block=%llu "\
+"wall_s=%.6f user_s=%.6f sys_s=%.6f mb_s=%.2f read_calls=%s write_calls=%s\n"
 /**
- * @brief ascii number of 'A'
+ * @brief bytes in a megabyte, for MB/s
  */
-#define UPPER_CASE_MIN 65
+#define MEGABYTE 1e6
 /**
- * @brief ascii number of 'Z'
+ * @brief nanoseconds and microseconds in a second
  */
-#define UPPER_CASE_MAX 90
+#define NANOS 1e9
+#define MICROS 1e6
 /**
- * @brief number of english letter in the alphabet
+ * @brief option of the brute command to write only the n most english like
+ * candidates
  */
-#define ENGLISH_LETTERS_NUM 26
+#define OPTION_TOP "--top"
+/**
+ * @brief option to send the job to a running cipherd instead of running it
+ */
+#define OPTION_DAEMON "--daemon"
+/**
+ * @brief request line of a job sent to cipherd with its files passed along -
+ * the command, k or the key, the flags and the passed input and output
+ */
+#define DAEMON_REQUEST "%s %s %s - -\n"
+/**
+ * @brief max number of bytes in a request line
+ */
+#define DAEMON_REQUEST_LEN 4096
+/**
+ * @brief daemon request flags - none, a translation table, a vigenere key
+ */
+#define DAEMON_NO_FLAGS "-"
+#define DAEMON_FLAG_TABLE "t"
+#define DAEMON_FLAG_KEY "v"
+/**
+ * @brief max number of worker threads
+ */
+#define MAX_THREADS 1024
+/**
+ * @brief max size of a read/write block - 1 GiB
+ */
+#define MAX_BLOCK_SIZE (1024 * 1024 * 1024)
+/**
+ * @brief error if an option or its value is invalid
+ */
+#define ERROR_OPTION "The given option is invalid\n"
+
+/**
+ * @brief run time options given after the positional program arguments
+ */
+typedef struct Options {
+    CipherOptions cipher;
+    bool is_batch;
+    bool is_follow;
+    const char *crc_path;
+    size_t top;
+    const char *daemon_path;
+    bool is_stats;
+} Options;
+
+/**
+ * @brief a snapshot of the clocks and counters of this process, taken when a
+ * run starts
+ */
+typedef struct RunStats {
+    double wall_seconds;
+    double user_seconds;
+    double system_seconds;
+    bool has_io;
+    CipherIoCounters io;
+    CipherTransformCounters transform;
+} RunStats;
 
 /**
  * @brief check whether the command given in main arguments is a valid command
@@ -99,7 +290,8 @@ bool CheckArgCommand(char *arg) {
  * @param out output file
  */
 void CloseFiles(FILE **in, FILE **out) {
-    if (*out != NULL) {
+    //when encoding in place both point to the same file
+    if (*out != NULL && *out != *in) {
         fclose(*out);
     }
     if (*in != NULL) {
@@ -108,15 +300,13 @@ void CloseFiles(FILE **in, FILE **out) {
 }
 
 /**
- * @brief validates the inputs for main program arguments by
- * program desired behavior
+ * @brief validates the number of arguments, the command and the shift
  * @param argc number of arguments received
  * @param argv array of arguments
  * @return true if all valid, else false if at least one error occurred
  */
-bool InputValidation(int argc, char *argv[], FILE **input) {
-    bool is_valid = true;
-    if (argc != NUM_ARGS) {
+bool ArgsValidation(int argc, char *argv[]) {
+    if (argc < NUM_ARGS) {
         fprintf(stderr, ERROR_ARGS);
         return false;
     }
@@ -128,6 +318,21 @@ bool InputValidation(int argc, char *argv[], FILE **input) {
         fprintf(stderr, ERROR_COMMAND);
         return false;
     }
+    return true;
+}
+
+/**
+ * @brief validates the inputs for main program arguments by
+ * program desired behavior
+ * @param argc number of arguments received
+ * @param argv array of arguments
+ * @return true if all valid, else false if at least one error occurred
+ */
+bool InputValidation(int argc, char *argv[], FILE **input) {
+    bool is_valid = true;
+    if (ArgsValidation(argc, argv) == false) {
+        return false;
+    }
     if (*input == NULL) {
         fprintf(stderr, FILE_ERROR);
         return false;
@@ -136,97 +341,430 @@ bool InputValidation(int argc, char *argv[], FILE **input) {
 }
 
 /**
- * @brief enocdes one char with the given shift number k
- * @param character the character to encode
- * @param shift_k the shifting number to encode with
- * @return the new enocded character in DEC
- */
-int EncodeChar(int character, int shift_k) {
-    shift_k %= ENGLISH_LETTERS_NUM;
-    if (character <= LOWER_CASE_MAX && character >= LOWER_CASE_MIN) {
-        character = (character + shift_k - LOWER_CASE_MIN) %
-                ENGLISH_LETTERS_NUM + LOWER_CASE_MIN;
-    } else if (character <= UPPER_CASE_MAX && character >= UPPER_CASE_MIN) {
-        character = (character + shift_k - UPPER_CASE_MIN) %
-                ENGLISH_LETTERS_NUM + UPPER_CASE_MIN;
-    }
-    return character;
+ * @brief parses a number given as an option value
+ * @param arg the option value string
+ * @param min the smallest value allowed
+ * @param max the biggest value allowed
+ * @param value out parameter to hold the parsed number
+ * @return true if the value is a valid number in [min, max], else false
+ */
+bool ParseNumber(const char *arg, unsigned long long min,
+                 unsigned long long max, unsigned long long *value) {
+    char *end = NULL;
+    if (arg == NULL || *arg < '0' || *arg > '9') {
+        return false;
+    }
+    errno = 0;
+    *value = strtoull(arg, &end, 10);
+    if (errno != 0 || *end != '\0' || *value < min || *value > max) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief parses the options that follow the positional program arguments
+ * @param argc number of arguments received
+ * @param argv array of arguments
+ * @param first_option index of the first option in argv
+ * @param options out parameter filled with the given or default options
+ * @return true if all options are valid, else false
+ */
+bool ParseOptions(int argc, char *argv[], int first_option,
+                  Options *options) {
+    unsigned long long value;
+    CipherDefaultOptions(&options->cipher);
+    options->is_batch = false;
+    options->is_follow = false;
+    options->crc_path = NULL;
+    options->top = 0;
+    options->daemon_path = NULL;
+    options->is_stats = false;
+    for (int i = first_option; i < argc; i++) {
+        if (strcmp(argv[i], OPTION_TABLE) == 0) {
+            options->cipher.use_table = true;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_MMAP) == 0) {
+            options->cipher.use_mmap = true;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_URING) == 0) {
+            options->cipher.use_uring = true;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_VIGENERE) == 0) {
+            options->cipher.key = argv[ARGUMENT_SHIFT];
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_BATCH) == 0) {
+            options->is_batch = true;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_BLOCK_SIZE) == 0 && i + 1 < argc
+            && ParseNumber(argv[i + 1], 1, MAX_BLOCK_SIZE, &value)) {
+            options->cipher.block_size = (size_t) value;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_THREADS) == 0 && i + 1 < argc
+            && ParseNumber(argv[i + 1], 1, MAX_THREADS, &value)) {
+            options->cipher.threads = (size_t) value;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_FOLLOW) == 0) {
+            options->is_follow = true;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_WATCH) == 0) {
+            options->is_follow = true;
+            options->cipher.use_watch = true;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_CRC) == 0) {
+            options->cipher.use_crc = true;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_CRC_FILE) == 0 && i + 1 < argc) {
+            options->cipher.use_crc = true;
+            options->crc_path = argv[i + 1];
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_UTF8) == 0) {
+            options->cipher.use_utf8 = true;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_STATS) == 0) {
+            options->is_stats = true;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_TOP) == 0 && i + 1 < argc
+            && ParseNumber(argv[i + 1], 1, BRUTE_SHIFTS, &value)) {
+            options->top = (size_t) value;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_DAEMON) == 0 && i + 1 < argc) {
+            options->daemon_path = argv[i + 1];
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_FRAMED) == 0) {
+            options->cipher.use_frames = true;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_FRAME_SIZE) == 0 && i + 1 < argc
+            && ParseNumber(argv[i + 1], 1, MAX_BLOCK_SIZE, &value)) {
+            options->cipher.frame_size = (size_t) value;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_RANGE) == 0 && i + 2 < argc
+            && ParseNumber(argv[i + 1], 0, ULLONG_MAX,
+                           &options->cipher.range_start)
+            && ParseNumber(argv[i + 2], 1, ULLONG_MAX,
+                           &options->cipher.range_len)) {
+            options->cipher.use_range = true;
+            i += 2;
+            continue;
+        }
+        fprintf(stderr, ERROR_OPTION);
+        return false;
+    }
+    return true;
 }
+
 /**
- * @brief enocoding main function - goes over the input file and encodes it
- * @param input the input file to encode
- * @param output the name of file to put the encoded text
- * @param k the shift  number for encoding
+ * @brief opens the input file for reading and the output file for writing,
+ * or one file for both when they are the same file
+ * @param input_path path of the input file
+ * @param output_path path of the output file
+ * @param input out parameter to hold the input, NULL if it failed to open
+ * @param output out parameter to hold the output, NULL if it failed to open
  */
-void EncodeInput(FILE **input, FILE **output, int k) {
-    int letter;
-    int output_letter;
-    //printing into output file the encoded text until end of input file reached
-    while ((letter = fgetc(*input)) != EOF) {
-        output_letter = EncodeChar(letter, k);
-        fprintf(*output, "%c", output_letter);
+void OpenFiles(const char *input_path, const char *output_path,
+               FILE **input, FILE **output) {
+    if (IsSameFile(input_path, output_path)) {
+        //encode in place, opening the output with w+ would empty the input
+        *input = fopen(input_path, "r+");
+        *output = *input;
+        return;
     }
+    *input = fopen(input_path, "r");
+    //not in append mode, the worker threads write at their own offsets
+    *output = *input == NULL ? NULL : fopen(output_path, "w+");
 }
 
 /**
- * @brief decoding one char with the given shift k number, uses encode fucntion
- * @param character the character to decode
- * @param shiftK the shift number to decode
- * @return the decoded character in DEC
+ * @brief takes a snapshot of the clocks and counters of this process
+ * @param stats out parameter to hold the snapshot
  */
-int DecodeChar(int character, int shift_k) {
-    shift_k %= ENGLISH_LETTERS_NUM;
-    return EncodeChar(character, ENGLISH_LETTERS_NUM - shift_k);
+void TakeStats(RunStats *stats) {
+    struct timespec now;
+    struct rusage usage;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    stats->wall_seconds = (double) now.tv_sec + (double) now.tv_nsec / NANOS;
+    getrusage(RUSAGE_SELF, &usage);
+    stats->user_seconds = (double) usage.ru_utime.tv_sec +
+            (double) usage.ru_utime.tv_usec / MICROS;
+    stats->system_seconds = (double) usage.ru_stime.tv_sec +
+            (double) usage.ru_stime.tv_usec / MICROS;
+    stats->has_io = CipherReadIoCounters(&stats->io);
+    CipherReadTransformCounters(&stats->transform);
 }
 
 /**
- * @brief main decoding function, gets input file and decodes it into output
- * file
- * @param input the input file to decode
- * @param output the output file to output the decoded text to
- * @param k the shifting number for decoding
+ * @brief prints the statistics line of a run to stderr, from a snapshot
+ * taken when it started until now
+ * @param start the snapshot taken when the run started
  */
-void DecodeInput(FILE **input, FILE **output, int k) {
-    int letter;
-    int output_letter;
-    //printing into output file the encoded text until end of input file reached
-    while ((letter = fgetc(*input)) != EOF) {
-        output_letter = DecodeChar(letter, k);
-        fprintf(*output, "%c", output_letter);
+void PrintStats(const RunStats *start) {
+    RunStats end;
+    char reads[32] = "-";
+    char writes[32] = "-";
+    TakeStats(&end);
+    unsigned long long bytes = end.transform.bytes - start->transform.bytes;
+    unsigned long long blocks = end.transform.blocks -
+            start->transform.blocks;
+    double wall_seconds = end.wall_seconds - start->wall_seconds;
+    if (start->has_io && end.has_io) {
+        snprintf(reads, sizeof(reads), "%llu",
+                 end.io.read_calls - start->io.read_calls);
+        snprintf(writes, sizeof(writes), "%llu",
+                 end.io.write_calls - start->io.write_calls);
     }
+    fprintf(stderr, STATS_LINE, bytes, blocks, blocks > 0 ? bytes / blocks : 0,
+            wall_seconds, end.user_seconds - start->user_seconds,
+            end.system_seconds - start->system_seconds,
+            wall_seconds > 0 ? (double) bytes / wall_seconds / MEGABYTE : 0.0,
+            reads, writes);
 }
 
 /**
- * @brief checking if file exists in path
- * @param file_name the file path/name to check
- * @return true if exists, otherwise false
+ * @brief runs the crack command - finds the shift the source file was
+ * encoded with, decodes it into the output file and prints the shift
+ * @param argc number of arguments
+ * @param argv array of the arguments
+ * @return EXIT_SUCCESS if the file was decoded, otherwise EXIT_FAILURE
  */
-bool CheckFileExists(char *file_name) {
-    FILE *file;
-    file = fopen(file_name, "r");
-    if (file) {
-        fclose(file);
-        return true;
+int CrackMain(int argc, char *argv[]) {
+    FILE *input_file = NULL;
+    FILE *output_file = NULL;
+    Options options;
+    int shift = 0;
+    if (argc < CRACK_NUM_ARGS) {
+        fprintf(stderr, ERROR_ARGS);
+        return EXIT_FAILURE;
+    }
+    if (ParseOptions(argc, argv, CRACK_NUM_ARGS, &options) == false) {
+        return EXIT_FAILURE;
+    }
+    //the key word would be read from the place of k, which crack does not have
+    if (options.is_batch || options.is_follow || options.cipher.key != NULL ||
+        options.cipher.use_frames || options.cipher.use_range ||
+        options.cipher.use_crc || options.cipher.use_utf8 || options.top > 0 ||
+        options.daemon_path != NULL) {
+        fprintf(stderr, ERROR_OPTION);
+        return EXIT_FAILURE;
+    }
+    OpenFiles(argv[CRACK_INPUT_FILE_PATH], argv[CRACK_OUTPUT_FILE_PATH],
+              &input_file, &output_file);
+    if (input_file == NULL || output_file == NULL) {
+        fprintf(stderr, FILE_ERROR);
+        CloseFiles(&input_file, &output_file);
+        return EXIT_FAILURE;
+    }
+    RunStats stats;
+    TakeStats(&stats);
+    bool is_done = CrackInput(&input_file, &output_file, &options.cipher,
+                              &shift);
+    CloseFiles(&input_file, &output_file);
+    if (options.is_stats) {
+        PrintStats(&stats);
+    }
+    if (is_done) {
+        printf(CRACK_RESULT, shift);
     }
-    return false;
+    return is_done ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 /**
- * @brief main function - gets program argumnets from user to perform desired
- * action, checks input output files, does validation on the user input,
- * proceeds with the decoding/encoding selected file
+ * @brief runs the brute command - decodes the source file with every shift,
+ * or the top most english like ones, reading it once, and prints the shift
+ * and path of every candidate from the most english like one
  * @param argc number of arguments
  * @param argv array of the arguments
- * @return EXIT_SUCCESS if the algorithm performed correctly, otherwise
+ * @return EXIT_SUCCESS if the candidates were written, otherwise EXIT_FAILURE
+ */
+int BruteMain(int argc, char *argv[]) {
+    Options options;
+    int shifts[BRUTE_SHIFTS];
+    size_t num_shifts = 0;
+    if (argc < BRUTE_NUM_ARGS) {
+        fprintf(stderr, ERROR_ARGS);
+        return EXIT_FAILURE;
+    }
+    if (ParseOptions(argc, argv, BRUTE_NUM_ARGS, &options) == false) {
+        return EXIT_FAILURE;
+    }
+    if (options.is_batch || options.is_follow || options.cipher.key != NULL ||
+        options.cipher.use_frames || options.cipher.use_range ||
+        options.cipher.use_crc || options.cipher.use_utf8 ||
+        options.daemon_path != NULL) {
+        fprintf(stderr, ERROR_OPTION);
+        return EXIT_FAILURE;
+    }
+    FILE *input_file = fopen(argv[BRUTE_INPUT_FILE_PATH], "r");
+    if (input_file == NULL) {
+        fprintf(stderr, FILE_ERROR);
+        return EXIT_FAILURE;
+    }
+    RunStats stats;
+    TakeStats(&stats);
+    bool is_done = BruteInput(&input_file, argv[BRUTE_OUTPUT_PREFIX],
+                              &options.cipher, options.top, shifts,
+                              &num_shifts);
+    fclose(input_file);
+    if (options.is_stats) {
+        PrintStats(&stats);
+    }
+    for (size_t i = 0; is_done && i < num_shifts; i++) {
+        printf(BRUTE_RESULT, shifts[i], argv[BRUTE_OUTPUT_PREFIX], shifts[i]);
+    }
+    return is_done ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief runs the batch mode - transforms every file listed by the source
+ * path into the output directory
+ * @param argc number of arguments
+ * @param argv array of the arguments
+ * @param options the run time options
+ * @return EXIT_SUCCESS if all files were transformed, otherwise EXIT_FAILURE
+ */
+int BatchMain(int argc, char *argv[], const Options *options) {
+    CipherContext context;
+    if (ArgsValidation(argc, argv) == false ||
+        CipherPrepare(&context, strcmp(argv[COMMAND], COMMAND_ENCODE) == 0 ?
+                                CIPHER_ENCODE : CIPHER_DECODE,
+                      atoi(argv[ARGUMENT_SHIFT]), &options->cipher) == false) {
+        return EXIT_FAILURE;
+    }
+    return BatchInput(argv[INPUT_FILE_PATH], argv[OUTPUT_FILE_PATH], &context,
+                      &options->cipher) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief runs the follow mode - transforms the bytes appended to the source
+ * file since the last run into the output file
+ * @param argc number of arguments
+ * @param argv array of the arguments
+ * @param options the run time options
+ * @return EXIT_SUCCESS if the new bytes were transformed, otherwise
  * EXIT_FAILURE
  */
-int main(int argc, char *argv[]) {
-    FILE *input_file = fopen(argv[INPUT_FILE_PATH], "r");
+int FollowMain(int argc, char *argv[], const Options *options) {
+    CipherContext context;
+    if (ArgsValidation(argc, argv) == false ||
+        CipherPrepare(&context, strcmp(argv[COMMAND], COMMAND_ENCODE) == 0 ?
+                                CIPHER_ENCODE : CIPHER_DECODE,
+                      atoi(argv[ARGUMENT_SHIFT]), &options->cipher) == false) {
+        return EXIT_FAILURE;
+    }
+    //the output grows behind the input, it can not be the input
+    if (IsSameFile(argv[INPUT_FILE_PATH], argv[OUTPUT_FILE_PATH])) {
+        fprintf(stderr, FILE_ERROR);
+        return EXIT_FAILURE;
+    }
+    return FollowInput(argv[INPUT_FILE_PATH], argv[OUTPUT_FILE_PATH], &context,
+                       &options->cipher) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief transforms the source file into the output file and checksums both
+ * in the same pass, then prints their CRC32C lines or writes them to the
+ * sidecar file
+ * @param argv array of the arguments
+ * @param input the input file
+ * @param output the output file
+ * @param options the run time options
+ * @return true on success, false if the transform failed or the sidecar
+ * could not be written
+ */
+bool ChecksumInput(char *argv[], FILE **input, FILE **output,
+                   const Options *options) {
+    CipherContext context;
+    if (CipherPrepare(&context, strcmp(argv[COMMAND], COMMAND_ENCODE) == 0 ?
+                                CIPHER_ENCODE : CIPHER_DECODE,
+                      atoi(argv[ARGUMENT_SHIFT]), &options->cipher) == false ||
+        ProcessInput(input, output, &context, &options->cipher) == false) {
+        return false;
+    }
+    FILE *sums = options->crc_path == NULL ? stdout :
+            fopen(options->crc_path, "w");
+    if (sums == NULL) {
+        fprintf(stderr, FILE_ERROR);
+        return false;
+    }
+    fprintf(sums, CRC_LINE, context.input_crc, argv[INPUT_FILE_PATH]);
+    fprintf(sums, CRC_LINE, context.output_crc, argv[OUTPUT_FILE_PATH]);
+    return sums == stdout || fclose(sums) == 0;
+}
+
+/**
+ * @brief sends the job to a running cipherd with the opened files, and
+ * waits until the daemon ran it
+ * @param argv array of the arguments
+ * @param input the input file
+ * @param output the output file, the input itself to transform in place
+ * @param options the run time options
+ * @return true if the daemon ran the job, else false
+ */
+bool DaemonInput(char *argv[], FILE **input, FILE **output,
+                 const Options *options) {
+    char request[DAEMON_REQUEST_LEN];
+    char flags[sizeof(DAEMON_FLAG_TABLE DAEMON_FLAG_KEY)] = "";
+    if (options->cipher.use_table) {
+        strcat(flags, DAEMON_FLAG_TABLE);
+    }
+    if (options->cipher.key != NULL) {
+        strcat(flags, DAEMON_FLAG_KEY);
+    }
+    int request_len = snprintf(request, sizeof(request), DAEMON_REQUEST,
+                               argv[COMMAND], argv[ARGUMENT_SHIFT],
+                               flags[0] == '\0' ? DAEMON_NO_FLAGS : flags);
+    if (request_len < 0 || (size_t) request_len >= sizeof(request)) {
+        fprintf(stderr, ERROR_SHIFT);
+        return false;
+    }
+    return CipherSubmit(options->daemon_path, request, fileno(*input),
+                        fileno(*output));
+}
+
+/**
+ * @brief runs an encode or decode job with validated options - a batch, a
+ * followed file, or a single file, through the daemon, checksummed or
+ * directly
+ * @param argc number of arguments
+ * @param argv array of the arguments
+ * @param options the run time options, parsed when argc has all arguments
+ * @return EXIT_SUCCESS if the job ran correctly, otherwise EXIT_FAILURE
+ */
+int RunJob(int argc, char *argv[], const Options *options) {
+    FILE *input_file = NULL;
     FILE *output_file = NULL;
-    if (CheckFileExists(argv[OUTPUT_FILE_PATH])) {
-        output_file = fopen(argv[OUTPUT_FILE_PATH], "w+");
-    } else {
-        output_file = fopen(argv[OUTPUT_FILE_PATH], "a+");
+    bool is_done = false;
+    if (argc >= NUM_ARGS && options->is_batch) {
+        return BatchMain(argc, argv, options);
+    }
+    if (argc >= NUM_ARGS && options->is_follow) {
+        return FollowMain(argc, argv, options);
+    }
+    if (argc >= NUM_ARGS) {
+        OpenFiles(argv[INPUT_FILE_PATH], argv[OUTPUT_FILE_PATH], &input_file,
+                  &output_file);
     }
 
     if (InputValidation(argc, argv, &input_file) == false) {
@@ -236,21 +774,83 @@ int main(int argc, char *argv[]) {
 
     if (output_file == NULL) {
         fprintf(stderr, FILE_ERROR);
+        CloseFiles(&input_file, &output_file);
         return EXIT_FAILURE;
     }
     //proceed to algorithm
-    if (strcmp(argv[COMMAND], COMMAND_ENCODE) == 0) {
-        EncodeInput(&input_file, &output_file, \
-        atoi(argv[ARGUMENT_SHIFT]));
+    if (options->daemon_path != NULL) {
+        is_done = DaemonInput(argv, &input_file, &output_file, options);
         CloseFiles(&input_file, &output_file);
-        return EXIT_SUCCESS;
+        return is_done ? EXIT_SUCCESS : EXIT_FAILURE;
     }
-    if (strcmp(argv[COMMAND], COMMAND_DECODE) == 0) {
-        DecodeInput(&input_file, &output_file, \
-        atoi(argv[ARGUMENT_SHIFT]));
+    if (options->cipher.use_crc) {
+        is_done = ChecksumInput(argv, &input_file, &output_file, options);
         CloseFiles(&input_file, &output_file);
-        return EXIT_SUCCESS;
+        return is_done ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    if (strcmp(argv[COMMAND], COMMAND_ENCODE) == 0) {
+        is_done = EncodeInput(&input_file, &output_file, \
+        atoi(argv[ARGUMENT_SHIFT]), &options->cipher);
+    }
+    if (strcmp(argv[COMMAND], COMMAND_DECODE) == 0) {
+        is_done = DecodeInput(&input_file, &output_file, \
+        atoi(argv[ARGUMENT_SHIFT]), &options->cipher);
     }
     CloseFiles(&input_file, &output_file);
+    return is_done ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
+/**
+ * @brief main function - gets program argumnets from user to perform desired
+ * action, checks input output files, does validation on the user input,
+ * proceeds with the decoding/encoding selected file
+ * @param argc number of arguments
+ * @param argv array of the arguments
+ * @return EXIT_SUCCESS if the algorithm performed correctly, otherwise
+ * EXIT_FAILURE
+ */
+int main(int argc, char *argv[]) {
+    Options options;
+    if (argc > COMMAND && strcmp(argv[COMMAND], COMMAND_CRACK) == 0) {
+        return CrackMain(argc, argv);
+    }
+    if (argc > COMMAND && strcmp(argv[COMMAND], COMMAND_BRUTE) == 0) {
+        return BruteMain(argc, argv);
+    }
+    if (argc >= NUM_ARGS &&
+        ParseOptions(argc, argv, NUM_ARGS, &options) == false) {
+        return EXIT_FAILURE;
+    }
+    //a range is only decoded from frames, batches and followed files are not
+    //framed, checksums and UTF-8 validation are only done over one whole file,
+    //and a daemon job runs, and is measured, in the daemon
+    if (argc >= NUM_ARGS && ((options.cipher.use_range &&
+                              (options.cipher.use_frames == false ||
+                               strcmp(argv[COMMAND], COMMAND_DECODE) != 0)) ||
+                             ((options.is_batch || options.is_follow) &&
+                              options.cipher.use_frames) ||
+                             (options.is_batch && options.is_follow) ||
+                             (options.cipher.use_crc &&
+                              (options.is_batch || options.is_follow ||
+                               options.cipher.use_frames)) ||
+                             (options.cipher.use_utf8 &&
+                              (options.is_batch || options.is_follow ||
+                               options.cipher.use_frames)) ||
+                             options.top > 0 ||
+                             (options.daemon_path != NULL &&
+                              (options.is_batch || options.is_follow ||
+                               options.cipher.use_frames ||
+                               options.cipher.use_crc ||
+                               options.cipher.use_utf8 || options.is_stats)))) {
+        fprintf(stderr, ERROR_OPTION);
+        return EXIT_FAILURE;
+    }
+    if (argc < NUM_ARGS || options.is_stats == false) {
+        return RunJob(argc, argv, &options);
+    }
+    RunStats stats;
+    TakeStats(&stats);
+    int status = RunJob(argc, argv, &options);
+    PrintStats(&stats);
+    return status;
+}
@@ -0,0 +1,581 @@
+/**
+ * Cipher throughput benchmark - generates synthetic corpora and reports the
+ * MB/s of every libcipher kernel and file engine, with the read and write
+ * system calls each engine made.
+ * Built with libcipher: gcc -O2 -pthread cipher_bench.c libcipher.c
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "libcipher.h"
+
+/**
+ * @brief index of the optional max corpus size in program args
+ */
+#define ARGUMENT_MAX_SIZE 1
+/**
+ * @brief index of the optional directory for the corpus files in program args
+ */
+#define ARGUMENT_DIR 2
+/**
+ * @brief max number of program arguments
+ */
+#define MAX_ARGS 3
+/**
+ * @brief error if the program arguments are invalid
+ */
+#define ERROR_ARGS "Usage: cipher_bench [max corpus size in bytes] "\
+"[directory for corpus files]\n"
+/**
+ * @brief error if memory allocation failed
+ */
+#define ERROR_ALLOC "Memory allocation failed\n"
+/**
+ * @brief error if a corpus file could not be created or written
+ */
+#define ERROR_FILE "Creating the corpus files failed\n"
+/**
+ * @brief smallest corpus - 4 KiB
+ */
+#define MIN_SIZE (4ULL * 1024)
+/**
+ * @brief default biggest corpus - 64 MiB
+ */
+#define DEFAULT_MAX_SIZE (64ULL * 1024 * 1024)
+/**
+ * @brief every corpus is this many times bigger than the previous one
+ */
+#define SIZE_STEP 16
+/**
+ * @brief kernels run on at most this many bytes in memory, bigger corpora
+ * only go through the file engines
+ */
+#define MAX_MEMORY_SIZE (256ULL * 1024 * 1024)
+/**
+ * @brief default directory for the corpus files
+ */
+#define DEFAULT_DIR "/tmp"
+/**
+ * @brief name of a corpus file under the directory, filled by mkstemp
+ */
+#define CORPUS_TEMPLATE "/cipher_bench_XXXXXX"
+/**
+ * @brief a kernel is run again until it ran for at least this long
+ */
+#define MIN_SECONDS 0.1
+/**
+ * @brief shift number used in all runs
+ */
+#define BENCH_SHIFT 3
+/**
+ * @brief vigenere key word used in the vigenere runs
+ */
+#define BENCH_KEY "LEMON"
+/**
+ * @brief bytes in a megabyte, for MB/s
+ */
+#define MEGABYTE 1e6
+/**
+ * @brief nanoseconds in a second
+ */
+#define NANOS 1e9
+/**
+ * @brief header of the results table
+ */
+#define RESULT_HEADER "%-8s %12s %-16s %10s %10s %10s\n"
+/**
+ * @brief a row of the results table
+ */
+#define RESULT_ROW "%-8s %12llu %-16s %10.1f %10s %10s\n"
+/**
+ * @brief lower case words the ascii corpus is made of
+ */
+#define ASCII_WORDS {"the", "of", "and", "to", "in", "is", "cipher", \
+"shift", "letter", "file", "block", "encode", "that", "with", "for", "on"}
+/**
+ * @brief number of words in ASCII_WORDS
+ */
+#define ASCII_WORDS_NUM 16
+/**
+ * @brief a line of the ascii corpus ends after about this many bytes
+ */
+#define ASCII_LINE_LEN 72
+/**
+ * @brief printable characters the mixed case corpus is made of
+ */
+#define MIXED_CHARS "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"\
+"0123456789 .,;:!?-_()[]{}\n"
+
+/**
+ * @brief the kinds of synthetic text
+ */
+typedef enum Corpus {
+    CORPUS_ASCII,
+    CORPUS_MIXED,
+    CORPUS_BINARY,
+    CORPUS_NUM
+} Corpus;
+
+/**
+ * @brief a kernel under test, run on a buffer in memory
+ */
+typedef struct BenchKernel {
+    const char *name;
+    const char *cpu_feature;
+    void (*run)(const unsigned char *in, unsigned char *out, size_t len);
+} BenchKernel;
+
+/**
+ * @brief a file engine under test, selected by its options
+ */
+typedef struct BenchEngine {
+    const char *name;
+    bool use_mmap;
+    bool use_threads;
+    bool use_uring;
+} BenchEngine;
+
+/**
+ * @brief translation table of the table kernels, built once
+ */
+unsigned char shift_table[TABLE_SIZE];
+
+/**
+ * @brief vigenere context of the vigenere kernels, built once
+ */
+CipherContext key_context;
+
+/**
+ * @brief scalar kernel - one EncodeChar per byte
+ */
+void RunScalar(const unsigned char *in, unsigned char *out, size_t len) {
+    EncodeBlock(in, out, len, BENCH_SHIFT);
+}
+
+/**
+ * @brief table kernel - one table lookup per byte
+ */
+void RunTable(const unsigned char *in, unsigned char *out, size_t len) {
+    TranslateBlock(in, out, len, shift_table);
+}
+
+/**
+ * @brief scalar vigenere kernel
+ */
+void RunKey(const unsigned char *in, unsigned char *out, size_t len) {
+    size_t key_pos = 0;
+    EncodeBlockKey(in, out, len, key_context.key_stream, key_context.key_len,
+                   &key_pos);
+}
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief SSE2 shift kernel
+ */
+void RunSse2(const unsigned char *in, unsigned char *out, size_t len) {
+    EncodeBlockSse2(in, out, len, BENCH_SHIFT);
+}
+
+/**
+ * @brief AVX2 shift kernel
+ */
+void RunAvx2(const unsigned char *in, unsigned char *out, size_t len) {
+    EncodeBlockAvx2(in, out, len, BENCH_SHIFT);
+}
+
+/**
+ * @brief AVX-512 shift kernel
+ */
+void RunAvx512(const unsigned char *in, unsigned char *out, size_t len) {
+    EncodeBlockAvx512(in, out, len, BENCH_SHIFT);
+}
+
+/**
+ * @brief SSSE3 table kernel
+ */
+void RunTableSsse3(const unsigned char *in, unsigned char *out, size_t len) {
+    TranslateBlockSsse3(in, out, len, shift_table);
+}
+
+/**
+ * @brief AVX2 table kernel
+ */
+void RunTableAvx2(const unsigned char *in, unsigned char *out, size_t len) {
+    TranslateBlockAvx2(in, out, len, shift_table);
+}
+
+/**
+ * @brief SSSE3 vigenere kernel
+ */
+void RunKeySsse3(const unsigned char *in, unsigned char *out, size_t len) {
+    size_t key_pos = 0;
+    EncodeBlockKeySsse3(in, out, len, key_context.key_stream,
+                        key_context.key_len, &key_pos);
+}
+
+/**
+ * @brief AVX2 vigenere kernel
+ */
+void RunKeyAvx2(const unsigned char *in, unsigned char *out, size_t len) {
+    size_t key_pos = 0;
+    EncodeBlockKeyAvx2(in, out, len, key_context.key_stream,
+                       key_context.key_len, &key_pos);
+}
+#endif
+
+/**
+ * @brief checks whether the running CPU has a feature a kernel needs
+ * @param feature name of the feature, NULL if the kernel needs none
+ * @return true if the kernel can run, else false
+ */
+bool HasCpuFeature(const char *feature) {
+    if (feature == NULL) {
+        return true;
+    }
+#ifdef HAS_X86_KERNELS
+    __builtin_cpu_init();
+    if (strcmp(feature, "sse2") == 0) {
+        return __builtin_cpu_supports("sse2");
+    }
+    if (strcmp(feature, "ssse3") == 0) {
+        return __builtin_cpu_supports("ssse3") &&
+                __builtin_cpu_supports("popcnt");
+    }
+    if (strcmp(feature, "avx2") == 0) {
+        return __builtin_cpu_supports("avx2");
+    }
+    if (strcmp(feature, "avx512bw") == 0) {
+        return __builtin_cpu_supports("avx512bw");
+    }
+#endif
+    return false;
+}
+
+/**
+ * @brief the kernels to run, a kernel whose cpu feature is missing is skipped
+ */
+const BenchKernel kernels[] = {
+        {"scalar", NULL, RunScalar},
+        {"table", NULL, RunTable},
+        {"vigenere", NULL, RunKey},
+#ifdef HAS_X86_KERNELS
+        {"sse2", "sse2", RunSse2},
+        {"avx2", "avx2", RunAvx2},
+        {"avx512", "avx512bw", RunAvx512},
+        {"table-ssse3", "ssse3", RunTableSsse3},
+        {"table-avx2", "avx2", RunTableAvx2},
+        {"vigenere-ssse3", "ssse3", RunKeySsse3},
+        {"vigenere-avx2", "avx2", RunKeyAvx2},
+#endif
+};
+
+/**
+ * @brief the file engines to run
+ */
+const BenchEngine engines[] = {
+        {"stream", false, false, false},
+        {"mmap", true, false, false},
+        {"threads", false, true, false},
+        {"uring", false, false, true},
+};
+
+/**
+ * @brief names of the corpora, by Corpus
+ */
+const char *corpus_names[CORPUS_NUM] = {"ascii", "mixed", "binary"};
+
+/**
+ * @brief next number of a xorshift generator, so every run gets the same
+ * corpora
+ * @param state the generator state, updated
+ * @return the next pseudo random number
+ */
+unsigned long long NextRandom(unsigned long long *state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/**
+ * @brief fills a buffer with synthetic text of a corpus kind
+ * @param corpus the kind of text
+ * @param buffer the buffer to fill
+ * @param len number of bytes to fill
+ * @param state the generator state, updated so consecutive calls continue
+ * the same corpus
+ */
+void FillCorpus(Corpus corpus, unsigned char *buffer, size_t len,
+                unsigned long long *state) {
+    const char *words[ASCII_WORDS_NUM] = ASCII_WORDS;
+    size_t i = 0;
+    size_t line_len = 0;
+    while (i < len) {
+        unsigned long long random = NextRandom(state);
+        if (corpus == CORPUS_BINARY) {
+            buffer[i++] = (unsigned char) random;
+        } else if (corpus == CORPUS_MIXED) {
+            buffer[i++] = (unsigned char) MIXED_CHARS[
+                    random % (sizeof(MIXED_CHARS) - 1)];
+        } else {
+            const char *word = words[random % ASCII_WORDS_NUM];
+            for (size_t j = 0; word[j] != '\0' && i < len; j++) {
+                buffer[i++] = (unsigned char) word[j];
+            }
+            line_len += strlen(word) + 1;
+            if (i < len) {
+                buffer[i++] = line_len > ASCII_LINE_LEN ? '\n' : ' ';
+            }
+            line_len = line_len > ASCII_LINE_LEN ? 0 : line_len;
+        }
+    }
+}
+
+/**
+ * @brief seconds of a monotonic clock
+ * @return the current time in seconds
+ */
+double Now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / NANOS;
+}
+
+/**
+ * @brief runs a kernel over a buffer until MIN_SECONDS passed
+ * @param kernel the kernel to run
+ * @param in the corpus
+ * @param out a buffer of the same size for the output
+ * @param len size of the corpus
+ * @return the throughput in MB/s
+ */
+double RunKernel(const BenchKernel *kernel, const unsigned char *in,
+                 unsigned char *out, size_t len) {
+    double start = Now();
+    double elapsed;
+    unsigned long long runs = 0;
+    do {
+        kernel->run(in, out, len);
+        runs++;
+        elapsed = Now() - start;
+    } while (elapsed < MIN_SECONDS);
+    return (double) len * (double) runs / elapsed / MEGABYTE;
+}
+
+/**
+ * @brief writes a corpus into a new file, block by block
+ * @param corpus the kind of text
+ * @param path template of the path, filled with the name of the new file
+ * @param size size of the corpus
+ * @param block a buffer of DEFAULT_BLOCK_SIZE bytes
+ * @return true on success, false if the file could not be written
+ */
+bool WriteCorpusFile(Corpus corpus, char *path, unsigned long long size,
+                     unsigned char *block) {
+    unsigned long long state = corpus + 1;
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return false;
+    }
+    FILE *file = fdopen(fd, "w");
+    if (file == NULL) {
+        close(fd);
+        return false;
+    }
+    for (unsigned long long written = 0; written < size;) {
+        size_t len = size - written < DEFAULT_BLOCK_SIZE ?
+                (size_t) (size - written) : DEFAULT_BLOCK_SIZE;
+        FillCorpus(corpus, block, len, &state);
+        if (fwrite(block, 1, len, file) != len) {
+            fclose(file);
+            return false;
+        }
+        written += len;
+    }
+    return fclose(file) == 0;
+}
+
+/**
+ * @brief prints a number of system calls into a table cell, "-" when not
+ * known
+ * @param cell the cell to print into
+ * @param cell_len size of the cell
+ * @param is_known whether the counters could be read
+ * @param calls number of calls
+ */
+void FormatCalls(char *cell, size_t cell_len, bool is_known,
+                 unsigned long long calls) {
+    if (is_known) {
+        snprintf(cell, cell_len, "%llu", calls);
+    } else {
+        snprintf(cell, cell_len, "-");
+    }
+}
+
+/**
+ * @brief encodes a corpus file once with a file engine and prints the
+ * throughput and the system calls of the run
+ * @param engine the engine to run
+ * @param corpus the kind of text, for the report
+ * @param input_path the corpus file
+ * @param output_path the file to encode into
+ * @param size size of the corpus
+ * @return true on success, false if the engine failed
+ */
+bool RunEngine(const BenchEngine *engine, Corpus corpus,
+               const char *input_path, const char *output_path,
+               unsigned long long size) {
+    CipherOptions options;
+    CipherIoCounters before;
+    CipherIoCounters after;
+    char reads[32];
+    char writes[32];
+    CipherDefaultOptions(&options);
+    options.use_mmap = engine->use_mmap;
+    options.use_uring = engine->use_uring;
+    if (engine->use_threads) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        options.threads = online > 1 ? (size_t) online : 2;
+    }
+    FILE *input = fopen(input_path, "r");
+    FILE *output = fopen(output_path, "w+");
+    if (input == NULL || output == NULL) {
+        if (input != NULL) {
+            fclose(input);
+        }
+        if (output != NULL) {
+            fclose(output);
+        }
+        return false;
+    }
+    bool is_known = CipherReadIoCounters(&before);
+    double start = Now();
+    bool is_valid = EncodeInput(&input, &output, BENCH_SHIFT, &options);
+    double elapsed = Now() - start;
+    is_known = CipherReadIoCounters(&after) && is_known;
+    fclose(input);
+    fclose(output);
+    FormatCalls(reads, sizeof(reads), is_known,
+                after.read_calls - before.read_calls);
+    FormatCalls(writes, sizeof(writes), is_known,
+                after.write_calls - before.write_calls);
+    printf(RESULT_ROW, corpus_names[corpus], size, engine->name,
+           (double) size / elapsed / MEGABYTE, reads, writes);
+    return is_valid;
+}
+
+/**
+ * @brief runs every kernel and every engine on a corpus of a given size
+ * @param corpus the kind of text
+ * @param size size of the corpus
+ * @param dir directory for the corpus files
+ * @param block a buffer of DEFAULT_BLOCK_SIZE bytes
+ * @return true on success, false if allocating or writing the corpus failed
+ */
+bool RunCorpus(Corpus corpus, unsigned long long size, const char *dir,
+               unsigned char *block) {
+    if (size <= MAX_MEMORY_SIZE) {
+        unsigned long long state = corpus + 1;
+        unsigned char *in = (unsigned char *) malloc((size_t) size);
+        unsigned char *out = (unsigned char *) malloc((size_t) size);
+        if (in == NULL || out == NULL) {
+            free(in);
+            free(out);
+            fprintf(stderr, ERROR_ALLOC);
+            return false;
+        }
+        FillCorpus(corpus, in, (size_t) size, &state);
+        for (size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); i++) {
+            if (HasCpuFeature(kernels[i].cpu_feature) == false) {
+                continue;
+            }
+            printf(RESULT_ROW, corpus_names[corpus], size, kernels[i].name,
+                   RunKernel(&kernels[i], in, out, (size_t) size), "-", "-");
+        }
+        free(in);
+        free(out);
+    }
+    size_t path_len = strlen(dir) + sizeof(CORPUS_TEMPLATE);
+    char *input_path = (char *) malloc(path_len);
+    char *output_path = (char *) malloc(path_len);
+    if (input_path == NULL || output_path == NULL) {
+        free(input_path);
+        free(output_path);
+        fprintf(stderr, ERROR_ALLOC);
+        return false;
+    }
+    snprintf(input_path, path_len, "%s%s", dir, CORPUS_TEMPLATE);
+    snprintf(output_path, path_len, "%s%s", dir, CORPUS_TEMPLATE);
+    int output_fd = mkstemp(output_path);
+    bool is_valid = output_fd >= 0 &&
+            WriteCorpusFile(corpus, input_path, size, block);
+    if (output_fd >= 0) {
+        close(output_fd);
+    }
+    if (is_valid == false) {
+        fprintf(stderr, ERROR_FILE);
+    }
+    for (size_t i = 0; is_valid && i < sizeof(engines) / sizeof(engines[0]);
+         i++) {
+        is_valid = RunEngine(&engines[i], corpus, input_path, output_path,
+                             size);
+    }
+    unlink(input_path);
+    unlink(output_path);
+    free(input_path);
+    free(output_path);
+    return is_valid;
+}
+
+/**
+ * @brief main function - runs the benchmark for all corpora from MIN_SIZE up
+ * to the max size, SIZE_STEP times bigger every time
+ * @param argc number of arguments
+ * @param argv array of the arguments
+ * @return EXIT_SUCCESS if all runs succeeded, otherwise EXIT_FAILURE
+ */
+int main(int argc, char *argv[]) {
+    unsigned long long max_size = DEFAULT_MAX_SIZE;
+    const char *dir = DEFAULT_DIR;
+    char *end = NULL;
+    if (argc > MAX_ARGS) {
+        fprintf(stderr, ERROR_ARGS);
+        return EXIT_FAILURE;
+    }
+    if (argc > ARGUMENT_MAX_SIZE) {
+        errno = 0;
+        max_size = strtoull(argv[ARGUMENT_MAX_SIZE], &end, 10);
+        if (errno != 0 || *end != '\0' || max_size < MIN_SIZE) {
+            fprintf(stderr, ERROR_ARGS);
+            return EXIT_FAILURE;
+        }
+    }
+    if (argc > ARGUMENT_DIR) {
+        dir = argv[ARGUMENT_DIR];
+    }
+    unsigned char *block = (unsigned char *) malloc(DEFAULT_BLOCK_SIZE);
+    if (block == NULL) {
+        fprintf(stderr, ERROR_ALLOC);
+        return EXIT_FAILURE;
+    }
+    BuildShiftTable(shift_table, BENCH_SHIFT);
+    CipherInitKey(&key_context, CIPHER_ENCODE, BENCH_KEY);
+    printf(RESULT_HEADER, "corpus", "bytes", "path", "MB/s", "reads",
+           "writes");
+    bool is_valid = true;
+    for (int corpus = 0; is_valid && corpus < CORPUS_NUM; corpus++) {
+        for (unsigned long long size = MIN_SIZE; is_valid && size <= max_size;
+             size *= SIZE_STEP) {
+            is_valid = RunCorpus((Corpus) corpus, size, dir, block);
+        }
+    }
+    free(block);
+    return is_valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
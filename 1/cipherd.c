@@ -0,0 +1,125 @@
+/**
+ * cipherd - the cipher daemon, runs encode and decode jobs sent over a unix
+ * domain socket on a warm pool of worker threads, so a job pays neither for
+ * starting a process nor for faulting in its buffers.
+ * Jobs are sent by cipher with the --daemon <socket path> option.
+ * Built with libcipher: gcc -O2 -pthread cipherd.c libcipher.c
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include "libcipher.h"
+
+/**
+ * @brief index of the socket path in program args
+ */
+#define ARGUMENT_SOCKET 1
+/**
+ * @brief numbers of expected arguments in the program arguments, options may
+ * follow them
+ */
+#define NUM_ARGS 2
+/**
+ * @brief error if the program arguments are invalid
+ */
+#define ERROR_ARGS "Usage: cipherd <socket path> [--threads <n>] "\
+"[--block-size <bytes>]\n"
+/**
+ * @brief option to set the number of worker threads
+ */
+#define OPTION_THREADS "--threads"
+/**
+ * @brief option to set the size of the blocks read and written at once
+ */
+#define OPTION_BLOCK_SIZE "--block-size"
+/**
+ * @brief max number of worker threads
+ */
+#define MAX_THREADS 1024
+/**
+ * @brief max size of a read/write block - 1 GiB
+ */
+#define MAX_BLOCK_SIZE (1024 * 1024 * 1024)
+
+/**
+ * @brief set by SIGINT and SIGTERM to stop the daemon
+ */
+volatile sig_atomic_t is_stopped = 0;
+
+/**
+ * @brief signal handler - stops the daemon once the pending jobs are done
+ * @param signal_number the signal received
+ */
+void Stop(int signal_number) {
+    (void) signal_number;
+    is_stopped = 1;
+}
+
+/**
+ * @brief parses a positive number given as an option value
+ * @param arg the option value string
+ * @param max the biggest value allowed
+ * @param value out parameter to hold the parsed number
+ * @return true if the value is a valid number in [1, max], else false
+ */
+bool ParseNumber(const char *arg, unsigned long long max,
+                 unsigned long long *value) {
+    char *end = NULL;
+    if (arg == NULL || *arg < '0' || *arg > '9') {
+        return false;
+    }
+    errno = 0;
+    *value = strtoull(arg, &end, 10);
+    return errno == 0 && *end == '\0' && *value > 0 && *value <= max;
+}
+
+/**
+ * @brief main function - parses the options, and serves jobs on the socket
+ * until SIGINT or SIGTERM
+ * @param argc number of arguments
+ * @param argv array of the arguments
+ * @return EXIT_SUCCESS when stopped, EXIT_FAILURE if the arguments are
+ * invalid or the socket could not be set up
+ */
+int main(int argc, char *argv[]) {
+    CipherOptions options;
+    unsigned long long value;
+    struct sigaction action;
+    CipherDefaultOptions(&options);
+    if (argc < NUM_ARGS) {
+        fprintf(stderr, ERROR_ARGS);
+        return EXIT_FAILURE;
+    }
+    for (int i = NUM_ARGS; i < argc; i++) {
+        if (strcmp(argv[i], OPTION_THREADS) == 0 && i + 1 < argc &&
+            ParseNumber(argv[i + 1], MAX_THREADS, &value)) {
+            options.threads = (size_t) value;
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], OPTION_BLOCK_SIZE) == 0 && i + 1 < argc &&
+            ParseNumber(argv[i + 1], MAX_BLOCK_SIZE, &value)) {
+            options.block_size = (size_t) value;
+            i++;
+            continue;
+        }
+        fprintf(stderr, ERROR_ARGS);
+        return EXIT_FAILURE;
+    }
+    //no SA_RESTART, the signal must interrupt accept
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = Stop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    //a client that goes away must not kill the daemon
+    signal(SIGPIPE, SIG_IGN);
+    return CipherServe(argv[ARGUMENT_SOCKET], &options, &is_stopped) ?
+           EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,3767 @@
+/**
+ * libcipher - the cipher algorithm as a library, encodes and decodes memory
+ * buffers and files inside the calling process
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "libcipher.h"
+
+#ifdef HAS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+/**
+ * @brief the io_uring engine can be compiled, it is set up through the raw
+ * system calls
+ */
+#define HAS_IO_URING
+#include <stdint.h>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#ifdef __linux__
+/**
+ * @brief followed files are watched with inotify, else polled
+ */
+#define HAS_INOTIFY
+#include <sys/inotify.h>
+#endif
+
+/**
+ * @brief ascii number of 'a'
+ */
+#define LOWER_CASE_MIN 97
+/**
+ * @brief ascii number of 'z'
+ */
+#define LOWER_CASE_MAX 122
+/**
+ * @brief ascii number of 'A'
+ */
+#define UPPER_CASE_MIN 65
+/**
+ * @brief ascii number of 'Z'
+ */
+#define UPPER_CASE_MAX 90
+/**
+ * @brief chunk boundaries of the worker threads are aligned to pages
+ */
+#define CHUNK_ALIGN 4096
+/**
+ * @brief error if reading the input or writing the output failed
+ */
+#define ERROR_IO "Reading or writing the given files failed\n"
+/**
+ * @brief error if memory allocation failed
+ */
+#define ERROR_ALLOC "Memory allocation failed\n"
+/**
+ * @brief error if one file of a batch could not be transformed
+ */
+#define ERROR_BATCH_FILE "Transforming %s into %s failed\n"
+/**
+ * @brief error if the batch manifest or directory could not be read
+ */
+#define ERROR_BATCH_SOURCE "The given batch manifest or directory is "\
+"invalid\n"
+/**
+ * @brief separator of directories in a path
+ */
+#define PATH_SEPARATOR "/"
+/**
+ * @brief characters that separate the input and output path of a manifest
+ * line, and end the line
+ */
+#define MANIFEST_DELIMS " \t\r\n"
+
+/**
+ * @brief bytes shifted by one SSE2 instruction
+ */
+#define SSE2_WIDTH 16
+/**
+ * @brief bytes shifted by one AVX2 instruction
+ */
+#define AVX2_WIDTH 32
+/**
+ * @brief bytes shifted by one AVX-512 instruction
+ */
+#define AVX512_WIDTH 64
+/**
+ * @brief bit that differs between an upper case letter and its lower case
+ */
+#define CASE_BIT 0x20
+/**
+ * @brief a translation table is looked up by pshufb as 16 rows of 16 entries,
+ * the high nibble of a byte picks the row and the low nibble the entry
+ */
+#define TABLE_ROW_LEN 16
+/**
+ * @brief mask of the low nibble of a byte
+ */
+#define LOW_NIBBLE 0x0f
+/**
+ * @brief bits in a nibble
+ */
+#define NIBBLE_BITS 4
+/**
+ * @brief the SSSE3 table kernel passes a table with more rows that remap
+ * bytes than this to TranslateBlock - every remapped row costs a lookup per
+ * vector, and at more rows the scalar lookup is as fast
+ */
+#define MAX_SSSE3_TABLE_ROWS 6
+/**
+ * @brief the AVX2 table kernel passes a table with more rows that remap
+ * bytes than this to TranslateBlock
+ */
+#define MAX_AVX2_TABLE_ROWS 12
+/**
+ * @brief 8 bit letter counters of the vectorized histogram are added to the
+ * totals before they can overflow, after this many vectors
+ */
+#define COUNT_FLUSH_VECTORS 255
+/**
+ * @brief number of samples spread over a regular file to crack its shift
+ */
+#define CRACK_SAMPLES 16
+/**
+ * @brief bytes read in every sample to crack a shift, and the prefix read
+ * from a pipe
+ */
+#define CRACK_SAMPLE_LEN (64 * 1024)
+/**
+ * @brief frequency of every letter a-z in english text
+ */
+#define ENGLISH_FREQUENCIES {0.08167, 0.01492, 0.02782, 0.04253, 0.12702, \
+0.02228, 0.02015, 0.06094, 0.06966, 0.00153, 0.00772, 0.04025, 0.02406, \
+0.06749, 0.07507, 0.01929, 0.00095, 0.05987, 0.06327, 0.09056, 0.02758, \
+0.00978, 0.02360, 0.00150, 0.01974, 0.00074}
+/**
+ * @brief kernel accounting of the I/O of this process
+ */
+#define IO_COUNTERS_PATH "/proc/self/io"
+/**
+ * @brief format of the read/write call and byte counters in IO_COUNTERS_PATH
+ */
+#define IO_COUNTERS_FORMAT "rchar: %llu wchar: %llu syscr: %llu syscw: %llu"
+/**
+ * @brief number of counters read by IO_COUNTERS_FORMAT
+ */
+#define IO_COUNTERS_NUM 4
+/**
+ * @brief error if a vigenere key word is empty, too long or not only letters
+ */
+#define ERROR_KEY "The given key is invalid\n"
+/**
+ * @brief path of the candidate of a shift, the output prefix and the shift
+ */
+#define BRUTE_PATH_FORMAT "%s.%d"
+/**
+ * @brief bytes BRUTE_PATH_FORMAT adds to the output prefix, with the
+ * terminating null
+ */
+#define BRUTE_SUFFIX_LEN 4
+/**
+ * @brief max number of bytes in a daemon request or reply line
+ */
+#define DAEMON_REQUEST_LEN 4096
+/**
+ * @brief number of file descriptors passed with a daemon request - the
+ * input and the output
+ */
+#define DAEMON_FDS 2
+/**
+ * @brief number of accepted connections waiting for a daemon worker
+ */
+#define DAEMON_QUEUE_LEN 64
+/**
+ * @brief fields of a daemon request line - "<encode|decode> <k|key> <flags>
+ * <input path> <output path>", separated by white space
+ */
+#define DAEMON_FIELDS 5
+#define DAEMON_FIELD_COMMAND 0
+#define DAEMON_FIELD_SHIFT 1
+#define DAEMON_FIELD_FLAGS 2
+#define DAEMON_FIELD_INPUT 3
+#define DAEMON_FIELD_OUTPUT 4
+/**
+ * @brief commands of a daemon request
+ */
+#define DAEMON_ENCODE "encode"
+#define DAEMON_DECODE "decode"
+/**
+ * @brief characters of the flags field - '-' for no flag, 't' to transform
+ * through a table, 'v' for a vigenere key word in place of k
+ */
+#define DAEMON_FLAGS "-tv"
+#define DAEMON_FLAG_TABLE 't'
+#define DAEMON_FLAG_KEY 'v'
+/**
+ * @brief input and output path of a request that passes its files
+ */
+#define DAEMON_PASSED_PATH "-"
+/**
+ * @brief a daemon client has this many milliseconds to send its whole
+ * request line, so a client that stays silent cannot hold a worker
+ */
+#define DAEMON_REQUEST_TIMEOUT_MS 5000
+/**
+ * @brief milliseconds in a second and nanoseconds in a millisecond
+ */
+#define MILLIS_PER_SECOND 1000
+#define NANOS_PER_MILLI 1000000
+/**
+ * @brief only the user running the daemon may connect to its socket
+ */
+#define DAEMON_SOCKET_MASK 0077
+/**
+ * @brief daemon reply lines
+ */
+#define DAEMON_REPLY_OK "ok\n"
+#define DAEMON_REPLY_REQUEST "error The given request is invalid\n"
+#define DAEMON_REPLY_SHIFT "error The given shift or key is invalid\n"
+#define DAEMON_REPLY_FILE "error The given file is invalid\n"
+#define DAEMON_REPLY_IO "error Reading or writing the given files failed\n"
+#define DAEMON_REPLY_ALLOC "error Memory allocation failed\n"
+/**
+ * @brief error if the daemon socket could not be set up or reached
+ */
+#define ERROR_DAEMON_SOCKET "The given daemon socket is invalid or not "\
+"reachable\n"
+/**
+ * @brief number of blocks the io_uring engine keeps in flight, every block
+ * is being read, waits to be transformed or is being written
+ */
+#define URING_DEPTH 8
+/**
+ * @brief first bytes of a framed file
+ */
+#define FRAME_MAGIC "CIPHFRM1"
+/**
+ * @brief number of bytes in FRAME_MAGIC
+ */
+#define FRAME_MAGIC_LEN 8
+/**
+ * @brief number of bytes of the frame size that follows the magic
+ */
+#define FRAME_SIZE_LEN 4
+/**
+ * @brief number of bytes in the header of a framed file - the magic and the
+ * frame size
+ */
+#define FRAME_FILE_HEADER_LEN (FRAME_MAGIC_LEN + FRAME_SIZE_LEN)
+/**
+ * @brief position and size of the input offset in a frame header
+ */
+#define FRAME_OFFSET_POS 0
+#define FRAME_OFFSET_LEN 8
+/**
+ * @brief position and size of the number of input bytes in a frame header
+ */
+#define FRAME_LENGTH_POS 8
+#define FRAME_LENGTH_LEN 4
+/**
+ * @brief position and size of the vigenere key position the frame starts at
+ * in a frame header
+ */
+#define FRAME_KEY_POS_POS 12
+#define FRAME_KEY_POS_LEN 4
+/**
+ * @brief position and size of the CRC32C of the encoded bytes in a frame
+ * header
+ */
+#define FRAME_CRC_POS 16
+#define FRAME_CRC_LEN 4
+/**
+ * @brief number of bytes in the header of a frame, all numbers are stored
+ * little endian
+ */
+#define FRAME_HEADER_LEN 20
+/**
+ * @brief max number of input bytes in a frame - 1 GiB
+ */
+#define MAX_FRAME_SIZE (1024 * 1024 * 1024)
+/**
+ * @brief reversed CRC32C (Castagnoli) polynomial
+ */
+#define CRC32C_POLY 0x82f63b78u
+/**
+ * @brief bits in a CRC32C checksum
+ */
+#define CRC_BITS 32
+/**
+ * @brief a checksummed or validated buffer is validated, checksummed,
+ * transformed and checksummed again in pieces of this many bytes, which stay
+ * in the L1 cache
+ */
+#define FUSE_LEN (16 * 1024)
+/**
+ * @brief bytes below this are ascii
+ */
+#define ASCII_LIMIT 0x80
+/**
+ * @brief range of a UTF-8 continuation byte
+ */
+#define UTF8_CONTINUATION_MIN 0x80
+#define UTF8_CONTINUATION_MAX 0xbf
+/**
+ * @brief error if the input is not valid UTF-8
+ */
+#define ERROR_UTF8 "The input is not valid UTF-8 at byte %llu\n"
+/**
+ * @brief error if a framed file is invalid or its checksums do not match
+ */
+#define ERROR_FRAMES "The given framed file is invalid or corrupted\n"
+/**
+ * @brief error if a framed file is to be encoded or decoded in place
+ */
+#define ERROR_FRAMES_IN_PLACE "Framed files can not be transformed in "\
+"place\n"
+/**
+ * @brief the checkpoint of a followed file is kept next to its output, under
+ * the output path and this suffix
+ */
+#define CHECKPOINT_SUFFIX ".checkpoint"
+/**
+ * @brief suffix of the temporary file a new checkpoint is written to
+ */
+#define CHECKPOINT_TEMP_SUFFIX ".tmp"
+/**
+ * @brief a checkpoint holds the number of input bytes done and the vigenere
+ * key position at that offset
+ */
+#define CHECKPOINT_FORMAT "%llu %zu\n"
+/**
+ * @brief number of values in CHECKPOINT_FORMAT
+ */
+#define CHECKPOINT_NUM 2
+/**
+ * @brief error if the checkpoint of a followed file can not be read
+ */
+#define ERROR_CHECKPOINT "The checkpoint of the output file is invalid\n"
+/**
+ * @brief permissions of a new output of a followed file, before the umask
+ */
+#define FOLLOW_OUTPUT_MODE 0666
+/**
+ * @brief size of the buffer inotify events are read into
+ */
+#define FOLLOW_EVENTS_LEN 4096
+/**
+ * @brief seconds between two looks at a followed file without inotify
+ */
+#define FOLLOW_POLL_SECONDS 1
+
+/**
+ * @brief a range of a file encoded by one worker thread, read with pread and
+ * written with pwrite at the same offsets
+ */
+typedef struct ChunkJob {
+    int input_fd;
+    int output_fd;
+    off_t start;
+    off_t end;
+    CipherContext context;
+    size_t block_size;
+    bool is_valid;
+} ChunkJob;
+
+/**
+ * @brief a run of frames of a framed file decoded by one worker thread. The
+ * parts of the frames inside [range_start, range_end) of the decoded file
+ * are written with pwrite to output_fd, or in order to output when
+ * output_fd is -1.
+ */
+typedef struct FrameJob {
+    int input_fd;
+    FILE *output;
+    int output_fd;
+    size_t frame_size;
+    unsigned long long first_frame;
+    unsigned long long end_frame;
+    unsigned long long range_start;
+    unsigned long long range_end;
+    const CipherContext *context;
+    bool is_valid;
+    bool is_corrupt;
+} FrameJob;
+
+/**
+ * @brief connections accepted by the daemon, waiting in a ring for the next
+ * free worker. Workers wait for has_job, the accepting thread for has_room.
+ */
+typedef struct DaemonPool {
+    int pending[DAEMON_QUEUE_LEN];
+    size_t head;
+    size_t len;
+    bool is_stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t has_job;
+    pthread_cond_t has_room;
+    const CipherOptions *options;
+} DaemonPool;
+
+/**
+ * @brief CRC32C of every byte value, built on first use
+ */
+unsigned crc32c_table[TABLE_SIZE];
+pthread_once_t crc32c_table_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief blocks and bytes transformed by CipherUpdate in this process, added
+ * to by every thread
+ */
+CipherTransformCounters transform_counters;
+
+#ifdef HAS_IO_URING
+/**
+ * @brief stage of a block of the io_uring engine
+ */
+typedef enum UringStage {
+    URING_FREE,
+    URING_READING,
+    URING_READ_DONE,
+    URING_WRITING
+} UringStage;
+
+/**
+ * @brief one block of the io_uring engine and the range of the files it
+ * holds. done is the number of bytes of the current read or write already
+ * completed, the rest is queued again after a short read or write.
+ */
+typedef struct UringSlot {
+    unsigned char *block;
+    off_t offset;
+    size_t len;
+    size_t done;
+    UringStage stage;
+} UringSlot;
+
+/**
+ * @brief an io_uring instance and its submission and completion rings
+ * mapped into this process
+ */
+typedef struct UringRing {
+    int fd;
+    void *sq_ring;
+    size_t sq_ring_len;
+    void *cq_ring;
+    size_t cq_ring_len;
+    struct io_uring_sqe *sqes;
+    size_t sqes_len;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned to_submit;
+} UringRing;
+#endif
+
+/**
+ * @brief one input file of a batch and the output file to transform it into
+ */
+typedef struct BatchJob {
+    char *input_path;
+    char *output_path;
+} BatchJob;
+
+/**
+ * @brief the jobs of a batch, grown by doubling its capacity
+ */
+typedef struct BatchList {
+    BatchJob *jobs;
+    size_t len;
+    size_t capacity;
+} BatchList;
+
+/**
+ * @brief state shared by the workers of a batch - every worker takes the
+ * next job under the lock until none is left
+ */
+typedef struct BatchPool {
+    const BatchList *list;
+    size_t next_job;
+    pthread_mutex_t lock;
+    const CipherContext *context;
+    const CipherOptions *options;
+    bool is_valid;
+} BatchPool;
+
+/**
+ * @brief enocdes one char with the given shift number k
+ * @param character the character to encode
+ * @param shift_k the shifting number to encode with
+ * @return the new enocded character in DEC
+ */
+int EncodeChar(int character, int shift_k) {
+    shift_k %= ENGLISH_LETTERS_NUM;
+    if (character <= LOWER_CASE_MAX && character >= LOWER_CASE_MIN) {
+        character = (character + shift_k - LOWER_CASE_MIN) %
+                ENGLISH_LETTERS_NUM + LOWER_CASE_MIN;
+    } else if (character <= UPPER_CASE_MAX && character >= UPPER_CASE_MIN) {
+        character = (character + shift_k - UPPER_CASE_MIN) %
+                ENGLISH_LETTERS_NUM + UPPER_CASE_MIN;
+    }
+    return character;
+}
+/**
+ * @brief checks whether a character is an english letter of any case
+ * @param character the character to check
+ * @return true if it is a letter, else false
+ */
+bool IsLetter(int character) {
+    return (character <= LOWER_CASE_MAX && character >= LOWER_CASE_MIN) ||
+            (character <= UPPER_CASE_MAX && character >= UPPER_CASE_MIN);
+}
+
+/**
+ * @brief encodes a whole block with the given shift number k
+ * @param in the bytes to encode
+ * @param out where to put the encoded bytes
+ * @param len number of bytes in the block
+ * @param shift_k the shifting number to encode with
+ */
+void EncodeBlock(const unsigned char *in, unsigned char *out,
+                 size_t len, int shift_k) {
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (unsigned char) EncodeChar(in[i], shift_k);
+    }
+}
+
+#ifdef HAS_X86_KERNELS
+/*
+ * The vectorized kernels encode a letter by its index in the alphabet,
+ * index = (character | CASE_BIT) - 'a', which is below 26 only for letters
+ * of both cases. A letter is moved by shift_k, or by shift_k - 26 when its
+ * index passes 25 - shift_k and it has to wrap back to 'a'/'A'.
+ */
+
+/**
+ * @brief encodes a block with the given shift number k, 16 bytes
+ * at a time
+ * @param in the bytes to encode
+ * @param out where to put the encoded bytes
+ * @param len number of bytes in the block
+ * @param shift_k the shifting number to encode with
+ */
+__attribute__((target("sse2")))
+void EncodeBlockSse2(const unsigned char *in, unsigned char *out,
+                     size_t len, int shift_k) {
+    shift_k %= ENGLISH_LETTERS_NUM;
+    const __m128i case_bit = _mm_set1_epi8(CASE_BIT);
+    const __m128i first = _mm_set1_epi8(LOWER_CASE_MIN);
+    const __m128i last_index = _mm_set1_epi8(ENGLISH_LETTERS_NUM - 1);
+    const __m128i last_unwrapped = _mm_set1_epi8(
+            (char) (ENGLISH_LETTERS_NUM - 1 - shift_k));
+    const __m128i shift = _mm_set1_epi8((char) shift_k);
+    const __m128i wrap = _mm_set1_epi8(-ENGLISH_LETTERS_NUM);
+    size_t i = 0;
+    for (; i + SSE2_WIDTH <= len; i += SSE2_WIDTH) {
+        __m128i chars = _mm_loadu_si128((const __m128i *) (in + i));
+        __m128i index = _mm_sub_epi8(_mm_or_si128(chars, case_bit), first);
+        __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(index, last_index),
+                                           index);
+        __m128i is_unwrapped = _mm_cmpeq_epi8(
+                _mm_min_epu8(index, last_unwrapped), index);
+        __m128i delta = _mm_add_epi8(shift, _mm_andnot_si128(is_unwrapped,
+                                                             wrap));
+        chars = _mm_add_epi8(chars, _mm_and_si128(is_letter, delta));
+        _mm_storeu_si128((__m128i *) (out + i), chars);
+    }
+    EncodeBlock(in + i, out + i, len - i, shift_k);
+}
+
+/**
+ * @brief encodes a block with the given shift number k, 32 bytes
+ * at a time
+ * @param in the bytes to encode
+ * @param out where to put the encoded bytes
+ * @param len number of bytes in the block
+ * @param shift_k the shifting number to encode with
+ */
+__attribute__((target("avx2")))
+void EncodeBlockAvx2(const unsigned char *in, unsigned char *out,
+                     size_t len, int shift_k) {
+    shift_k %= ENGLISH_LETTERS_NUM;
+    const __m256i case_bit = _mm256_set1_epi8(CASE_BIT);
+    const __m256i first = _mm256_set1_epi8(LOWER_CASE_MIN);
+    const __m256i last_index = _mm256_set1_epi8(ENGLISH_LETTERS_NUM - 1);
+    const __m256i last_unwrapped = _mm256_set1_epi8(
+            (char) (ENGLISH_LETTERS_NUM - 1 - shift_k));
+    const __m256i shift = _mm256_set1_epi8((char) shift_k);
+    const __m256i wrap = _mm256_set1_epi8(-ENGLISH_LETTERS_NUM);
+    size_t i = 0;
+    for (; i + AVX2_WIDTH <= len; i += AVX2_WIDTH) {
+        __m256i chars = _mm256_loadu_si256((const __m256i *) (in + i));
+        __m256i index = _mm256_sub_epi8(_mm256_or_si256(chars, case_bit),
+                                        first);
+        __m256i is_letter = _mm256_cmpeq_epi8(
+                _mm256_min_epu8(index, last_index), index);
+        __m256i is_unwrapped = _mm256_cmpeq_epi8(
+                _mm256_min_epu8(index, last_unwrapped), index);
+        __m256i delta = _mm256_add_epi8(
+                shift, _mm256_andnot_si256(is_unwrapped, wrap));
+        chars = _mm256_add_epi8(chars, _mm256_and_si256(is_letter, delta));
+        _mm256_storeu_si256((__m256i *) (out + i), chars);
+    }
+    EncodeBlockSse2(in + i, out + i, len - i, shift_k);
+}
+
+/**
+ * @brief encodes a block with the given shift number k, 64 bytes
+ * at a time
+ * @param in the bytes to encode
+ * @param out where to put the encoded bytes
+ * @param len number of bytes in the block
+ * @param shift_k the shifting number to encode with
+ */
+__attribute__((target("avx512f,avx512bw")))
+void EncodeBlockAvx512(const unsigned char *in, unsigned char *out,
+                       size_t len, int shift_k) {
+    shift_k %= ENGLISH_LETTERS_NUM;
+    const __m512i case_bit = _mm512_set1_epi8(CASE_BIT);
+    const __m512i first = _mm512_set1_epi8(LOWER_CASE_MIN);
+    const __m512i last_index = _mm512_set1_epi8(ENGLISH_LETTERS_NUM - 1);
+    const __m512i last_unwrapped = _mm512_set1_epi8(
+            (char) (ENGLISH_LETTERS_NUM - 1 - shift_k));
+    const __m512i shift = _mm512_set1_epi8((char) shift_k);
+    const __m512i wrapped_shift = _mm512_set1_epi8(
+            (char) (shift_k - ENGLISH_LETTERS_NUM));
+    size_t i = 0;
+    for (; i + AVX512_WIDTH <= len; i += AVX512_WIDTH) {
+        __m512i chars = _mm512_loadu_si512((const void *) (in + i));
+        __m512i index = _mm512_sub_epi8(_mm512_or_si512(chars, case_bit),
+                                        first);
+        __mmask64 is_letter = _mm512_cmple_epu8_mask(index, last_index);
+        __mmask64 is_wrapped = _mm512_cmpgt_epu8_mask(index, last_unwrapped);
+        __m512i delta = _mm512_mask_blend_epi8(is_wrapped, shift,
+                                               wrapped_shift);
+        chars = _mm512_mask_add_epi8(chars, is_letter, chars, delta);
+        _mm512_storeu_si512((void *) (out + i), chars);
+    }
+    EncodeBlockAvx2(in + i, out + i, len - i, shift_k);
+}
+#endif
+
+/**
+ * @brief fills a translation table that encodes every byte value with the
+ * given shift number k
+ * @param table the table of TABLE_SIZE entries to fill
+ * @param shift_k the shifting number to encode with
+ */
+void BuildShiftTable(unsigned char *table, int shift_k) {
+    for (int character = 0; character < TABLE_SIZE; character++) {
+        table[character] = (unsigned char) EncodeChar(character, shift_k);
+    }
+}
+
+/**
+ * @brief maps every byte of a block through a translation table
+ * @param in the bytes to map
+ * @param out where to put the mapped bytes
+ * @param len number of bytes in the block
+ * @param table the translation table of TABLE_SIZE entries
+ */
+void TranslateBlock(const unsigned char *in, unsigned char *out,
+                    size_t len, const unsigned char *table) {
+    for (size_t i = 0; i < len; i++) {
+        out[i] = table[in[i]];
+    }
+}
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief finds the rows of a translation table that remap bytes - in any
+ * other row every byte maps to itself
+ * @param table the translation table of TABLE_SIZE entries
+ * @param rows where to put the numbers of the rows that remap bytes, in
+ * order
+ * @return number of rows that remap bytes
+ */
+int FindTableRows(const unsigned char *table, int *rows) {
+    int num_rows = 0;
+    for (int row = 0; row < TABLE_ROW_LEN; row++) {
+        for (int entry = 0; entry < TABLE_ROW_LEN; entry++) {
+            int character = row * TABLE_ROW_LEN + entry;
+            if (table[character] != character) {
+                rows[num_rows] = row;
+                num_rows++;
+                break;
+            }
+        }
+    }
+    return num_rows;
+}
+
+/**
+ * @brief loads the row of a translation table as what every entry adds to
+ * its byte, so bytes of other rows pass through with nothing added
+ * @param table the translation table of TABLE_SIZE entries
+ * @param row number of the row
+ * @return the 16 differences of the row
+ */
+__attribute__((target("ssse3")))
+__m128i LoadTableRowDelta(const unsigned char *table, int row) {
+    unsigned char delta[TABLE_ROW_LEN];
+    for (int entry = 0; entry < TABLE_ROW_LEN; entry++) {
+        delta[entry] = (unsigned char) (table[row * TABLE_ROW_LEN + entry] -
+                row * TABLE_ROW_LEN - entry);
+    }
+    return _mm_loadu_si128((const __m128i *) delta);
+}
+
+/**
+ * @brief maps every byte of a block through a translation table,
+ * 16 bytes at a time with a pshufb lookup in every row that remaps bytes
+ * @param in the bytes to map
+ * @param out where to put the mapped bytes
+ * @param len number of bytes in the block
+ * @param table the translation table of TABLE_SIZE entries
+ */
+__attribute__((target("ssse3")))
+void TranslateBlockSsse3(const unsigned char *in, unsigned char *out,
+                         size_t len, const unsigned char *table) {
+    int rows[TABLE_ROW_LEN];
+    int num_rows = FindTableRows(table, rows);
+    if (num_rows > MAX_SSSE3_TABLE_ROWS) {
+        TranslateBlock(in, out, len, table);
+        return;
+    }
+    __m128i deltas[TABLE_ROW_LEN];
+    __m128i row_ids[TABLE_ROW_LEN];
+    const __m128i low_nibble = _mm_set1_epi8(LOW_NIBBLE);
+    size_t i = 0;
+    for (int row = 0; row < num_rows; row++) {
+        deltas[row] = LoadTableRowDelta(table, rows[row]);
+        row_ids[row] = _mm_set1_epi8((char) rows[row]);
+    }
+    for (; i + SSE2_WIDTH <= len; i += SSE2_WIDTH) {
+        __m128i chars = _mm_loadu_si128((const __m128i *) (in + i));
+        __m128i low = _mm_and_si128(chars, low_nibble);
+        __m128i high = _mm_and_si128(_mm_srli_epi16(chars, NIBBLE_BITS),
+                                     low_nibble);
+        __m128i delta = _mm_setzero_si128();
+        for (int row = 0; row < num_rows; row++) {
+            __m128i in_row = _mm_cmpeq_epi8(high, row_ids[row]);
+            delta = _mm_or_si128(delta, _mm_and_si128(
+                    in_row, _mm_shuffle_epi8(deltas[row], low)));
+        }
+        _mm_storeu_si128((__m128i *) (out + i), _mm_add_epi8(chars, delta));
+    }
+    TranslateBlock(in + i, out + i, len - i, table);
+}
+
+/**
+ * @brief maps every byte of a block through a translation table,
+ * 32 bytes at a time with a pshufb lookup in every row that remaps bytes
+ * @param in the bytes to map
+ * @param out where to put the mapped bytes
+ * @param len number of bytes in the block
+ * @param table the translation table of TABLE_SIZE entries
+ */
+__attribute__((target("avx2")))
+void TranslateBlockAvx2(const unsigned char *in, unsigned char *out,
+                        size_t len, const unsigned char *table) {
+    int rows[TABLE_ROW_LEN];
+    int num_rows = FindTableRows(table, rows);
+    if (num_rows > MAX_AVX2_TABLE_ROWS) {
+        TranslateBlock(in, out, len, table);
+        return;
+    }
+    __m256i deltas[TABLE_ROW_LEN];
+    __m256i row_ids[TABLE_ROW_LEN];
+    const __m256i low_nibble = _mm256_set1_epi8(LOW_NIBBLE);
+    size_t i = 0;
+    for (int row = 0; row < num_rows; row++) {
+        deltas[row] = _mm256_broadcastsi128_si256(
+                LoadTableRowDelta(table, rows[row]));
+        row_ids[row] = _mm256_set1_epi8((char) rows[row]);
+    }
+    //two vectors share every row lookup of a pass
+    for (; i + 2 * AVX2_WIDTH <= len; i += 2 * AVX2_WIDTH) {
+        __m256i chars = _mm256_loadu_si256((const __m256i *) (in + i));
+        __m256i next_chars = _mm256_loadu_si256(
+                (const __m256i *) (in + i + AVX2_WIDTH));
+        __m256i low = _mm256_and_si256(chars, low_nibble);
+        __m256i next_low = _mm256_and_si256(next_chars, low_nibble);
+        __m256i high = _mm256_and_si256(
+                _mm256_srli_epi16(chars, NIBBLE_BITS), low_nibble);
+        __m256i next_high = _mm256_and_si256(
+                _mm256_srli_epi16(next_chars, NIBBLE_BITS), low_nibble);
+        __m256i delta = _mm256_setzero_si256();
+        __m256i next_delta = _mm256_setzero_si256();
+        for (int row = 0; row < num_rows; row++) {
+            delta = _mm256_or_si256(delta, _mm256_and_si256(
+                    _mm256_cmpeq_epi8(high, row_ids[row]),
+                    _mm256_shuffle_epi8(deltas[row], low)));
+            next_delta = _mm256_or_si256(next_delta, _mm256_and_si256(
+                    _mm256_cmpeq_epi8(next_high, row_ids[row]),
+                    _mm256_shuffle_epi8(deltas[row], next_low)));
+        }
+        _mm256_storeu_si256((__m256i *) (out + i),
+                            _mm256_add_epi8(chars, delta));
+        _mm256_storeu_si256((__m256i *) (out + i + AVX2_WIDTH),
+                            _mm256_add_epi8(next_chars, next_delta));
+    }
+    TranslateBlockSsse3(in + i, out + i, len - i, table);
+}
+#endif
+
+/**
+ * @brief picks the widest table kernel the running CPU supports,
+ * TranslateBlock is the fallback for any other CPU
+ * @return the kernel to map blocks with
+ */
+TableKernel SelectTableKernel(void) {
+#ifdef HAS_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return TranslateBlockAvx2;
+    }
+    if (__builtin_cpu_supports("ssse3")) {
+        return TranslateBlockSsse3;
+    }
+#endif
+    return TranslateBlock;
+}
+
+/**
+ * @brief picks the widest encoding kernel the running CPU supports,
+ * EncodeBlock is the fallback for any other CPU
+ * @return the kernel to encode blocks with
+ */
+ShiftKernel SelectShiftKernel(void) {
+#ifdef HAS_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) {
+        return EncodeBlockAvx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return EncodeBlockAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return EncodeBlockSse2;
+    }
+#endif
+    return EncodeBlock;
+}
+
+/**
+ * @brief encodes a block with a vigenere key stream - every letter is shifted
+ * by the next shift of the key stream, other bytes are kept and do not use
+ * a shift
+ * @param in the bytes to encode
+ * @param out where to put the encoded bytes
+ * @param len number of bytes in the block
+ * @param key_stream the shifts of the key, repeated
+ * @param key_len number of letters in the key
+ * @param key_pos position in the key of the next letter, updated
+ */
+void EncodeBlockKey(const unsigned char *in, unsigned char *out, size_t len,
+                    const unsigned char *key_stream, size_t key_len,
+                    size_t *key_pos) {
+    size_t pos = *key_pos;
+    for (size_t i = 0; i < len; i++) {
+        if (IsLetter(in[i])) {
+            out[i] = (unsigned char) EncodeChar(in[i], key_stream[pos]);
+            pos = pos + 1 == key_len ? 0 : pos + 1;
+        } else {
+            out[i] = in[i];
+        }
+    }
+    *key_pos = pos;
+}
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief the period a vector kernel keeps its key stream position in - the
+ * smallest whole number of key lengths that is at least the vector width,
+ * so a vector moves the position past it at most once
+ * @param key_len number of letters in the key
+ * @param width number of bytes in a vector
+ * @return the period
+ */
+size_t KeyStreamPeriod(size_t key_len, size_t width) {
+    return key_len * ((width + key_len - 1) / key_len);
+}
+
+/**
+ * @brief encodes a block with a vigenere key stream 16 bytes at a time.
+ * The position in the key of every letter is key_pos plus the number of
+ * letters before it in the vector, an exclusive prefix sum of the letter
+ * mask. pshufb of the 16 key stream shifts from key_pos with these positions
+ * gives every letter its shift. The position is kept below a period of the
+ * key with one subtraction, so no division is on the path between vectors.
+ * @param in the bytes to encode
+ * @param out where to put the encoded bytes
+ * @param len number of bytes in the block
+ * @param key_stream the shifts of the key, repeated
+ * @param key_len number of letters in the key
+ * @param key_pos position in the key of the next letter, updated
+ */
+__attribute__((target("ssse3,popcnt")))
+void EncodeBlockKeySsse3(const unsigned char *in, unsigned char *out,
+                         size_t len, const unsigned char *key_stream,
+                         size_t key_len, size_t *key_pos) {
+    const __m128i case_bit = _mm_set1_epi8(CASE_BIT);
+    const __m128i first = _mm_set1_epi8(LOWER_CASE_MIN);
+    const __m128i last_index = _mm_set1_epi8(ENGLISH_LETTERS_NUM - 1);
+    const __m128i wrap = _mm_set1_epi8(-ENGLISH_LETTERS_NUM);
+    const __m128i one = _mm_set1_epi8(1);
+    const size_t period = KeyStreamPeriod(key_len, SSE2_WIDTH);
+    size_t pos = *key_pos;
+    size_t i = 0;
+    for (; i + SSE2_WIDTH <= len; i += SSE2_WIDTH) {
+        __m128i chars = _mm_loadu_si128((const __m128i *) (in + i));
+        __m128i index = _mm_sub_epi8(_mm_or_si128(chars, case_bit), first);
+        __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(index, last_index),
+                                           index);
+        __m128i letters = _mm_and_si128(is_letter, one);
+        __m128i before = _mm_slli_si128(letters, 1);
+        before = _mm_add_epi8(before, _mm_slli_si128(before, 1));
+        before = _mm_add_epi8(before, _mm_slli_si128(before, 2));
+        before = _mm_add_epi8(before, _mm_slli_si128(before, 4));
+        before = _mm_add_epi8(before, _mm_slli_si128(before, 8));
+        __m128i shift = _mm_shuffle_epi8(
+                _mm_loadu_si128((const __m128i *) (key_stream + pos)), before);
+        __m128i moved = _mm_add_epi8(index, shift);
+        __m128i is_unwrapped = _mm_cmpeq_epi8(_mm_min_epu8(moved, last_index),
+                                              moved);
+        __m128i delta = _mm_add_epi8(shift, _mm_andnot_si128(is_unwrapped,
+                                                             wrap));
+        chars = _mm_add_epi8(chars, _mm_and_si128(is_letter, delta));
+        _mm_storeu_si128((__m128i *) (out + i), chars);
+        pos += (size_t) __builtin_popcount(
+                (unsigned) _mm_movemask_epi8(is_letter));
+        pos = pos >= period ? pos - period : pos;
+    }
+    *key_pos = pos % key_len;
+    EncodeBlockKey(in + i, out + i, len - i, key_stream, key_len, key_pos);
+}
+
+/**
+ * @brief encodes a block with a vigenere key stream 32 bytes at a time, as
+ * EncodeBlockKeySsse3. pshufb looks up in each 128 bit lane on its own, so
+ * the prefix sum is taken per lane and the high lane gets the 16 shifts from
+ * after the letters of the low lane.
+ * @param in the bytes to encode
+ * @param out where to put the encoded bytes
+ * @param len number of bytes in the block
+ * @param key_stream the shifts of the key, repeated
+ * @param key_len number of letters in the key
+ * @param key_pos position in the key of the next letter, updated
+ */
+__attribute__((target("avx2,popcnt")))
+void EncodeBlockKeyAvx2(const unsigned char *in, unsigned char *out,
+                        size_t len, const unsigned char *key_stream,
+                        size_t key_len, size_t *key_pos) {
+    const __m256i case_bit = _mm256_set1_epi8(CASE_BIT);
+    const __m256i first = _mm256_set1_epi8(LOWER_CASE_MIN);
+    const __m256i last_index = _mm256_set1_epi8(ENGLISH_LETTERS_NUM - 1);
+    const __m256i wrap = _mm256_set1_epi8(-ENGLISH_LETTERS_NUM);
+    const __m256i one = _mm256_set1_epi8(1);
+    const size_t period = KeyStreamPeriod(key_len, AVX2_WIDTH);
+    size_t pos = *key_pos;
+    size_t i = 0;
+    for (; i + AVX2_WIDTH <= len; i += AVX2_WIDTH) {
+        __m256i chars = _mm256_loadu_si256((const __m256i *) (in + i));
+        __m256i index = _mm256_sub_epi8(_mm256_or_si256(chars, case_bit),
+                                        first);
+        __m256i is_letter = _mm256_cmpeq_epi8(
+                _mm256_min_epu8(index, last_index), index);
+        __m256i letters = _mm256_and_si256(is_letter, one);
+        __m256i before = _mm256_slli_si256(letters, 1);
+        before = _mm256_add_epi8(before, _mm256_slli_si256(before, 1));
+        before = _mm256_add_epi8(before, _mm256_slli_si256(before, 2));
+        before = _mm256_add_epi8(before, _mm256_slli_si256(before, 4));
+        before = _mm256_add_epi8(before, _mm256_slli_si256(before, 8));
+        unsigned mask = (unsigned) _mm256_movemask_epi8(is_letter);
+        size_t low_letters = (size_t) __builtin_popcount(mask & 0xffffU);
+        __m256i stream = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128(
+                        (const __m128i *) (key_stream + pos))),
+                _mm_loadu_si128(
+                        (const __m128i *) (key_stream + pos + low_letters)),
+                1);
+        __m256i shift = _mm256_shuffle_epi8(stream, before);
+        __m256i moved = _mm256_add_epi8(index, shift);
+        __m256i is_unwrapped = _mm256_cmpeq_epi8(
+                _mm256_min_epu8(moved, last_index), moved);
+        __m256i delta = _mm256_add_epi8(
+                shift, _mm256_andnot_si256(is_unwrapped, wrap));
+        chars = _mm256_add_epi8(chars, _mm256_and_si256(is_letter, delta));
+        _mm256_storeu_si256((__m256i *) (out + i), chars);
+        pos += (size_t) __builtin_popcount(mask);
+        pos = pos >= period ? pos - period : pos;
+    }
+    *key_pos = pos % key_len;
+    EncodeBlockKeySsse3(in + i, out + i, len - i, key_stream, key_len,
+                        key_pos);
+}
+#endif
+
+/**
+ * @brief picks the widest vigenere kernel the running CPU supports,
+ * EncodeBlockKey is the fallback for any other CPU
+ * @return the kernel to encode blocks with a key stream
+ */
+KeyKernel SelectKeyKernel(void) {
+#ifdef HAS_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return EncodeBlockKeyAvx2;
+    }
+    if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("popcnt")) {
+        return EncodeBlockKeySsse3;
+    }
+#endif
+    return EncodeBlockKey;
+}
+
+/**
+ * @brief finds the length of the run of ascii bytes a block starts with
+ * @param in the bytes to check
+ * @param len number of bytes in the block
+ * @return number of ascii bytes before the first byte >= 0x80, len if all
+ * bytes are ascii
+ */
+size_t AsciiPrefix(const unsigned char *in, size_t len) {
+    size_t i = 0;
+    while (i < len && in[i] < ASCII_LIMIT) {
+        i++;
+    }
+    return i;
+}
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief AsciiPrefix 16 bytes at a time - the sign bits of a vector are set
+ * exactly for its bytes >= 0x80
+ */
+__attribute__((target("sse2")))
+size_t AsciiPrefixSse2(const unsigned char *in, size_t len) {
+    size_t i = 0;
+    for (; i + SSE2_WIDTH <= len; i += SSE2_WIDTH) {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) (in + i));
+        int mask = _mm_movemask_epi8(bytes);
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + AsciiPrefix(in + i, len - i);
+}
+
+/**
+ * @brief AsciiPrefix 64 bytes at a time, as AsciiPrefixSse2 with two AVX2
+ * vectors or'ed together
+ */
+__attribute__((target("avx2")))
+size_t AsciiPrefixAvx2(const unsigned char *in, size_t len) {
+    size_t i = 0;
+    for (; i + 2 * AVX2_WIDTH <= len; i += 2 * AVX2_WIDTH) {
+        __m256i low = _mm256_loadu_si256((const __m256i *) (in + i));
+        __m256i high = _mm256_loadu_si256((const __m256i *) (in + i +
+                                                             AVX2_WIDTH));
+        if (_mm256_movemask_epi8(_mm256_or_si256(low, high)) != 0) {
+            break;
+        }
+    }
+    for (; i + AVX2_WIDTH <= len; i += AVX2_WIDTH) {
+        __m256i bytes = _mm256_loadu_si256((const __m256i *) (in + i));
+        int mask = _mm256_movemask_epi8(bytes);
+        if (mask != 0) {
+            return i + (size_t) __builtin_ctz((unsigned) mask);
+        }
+    }
+    return i + AsciiPrefix(in + i, len - i);
+}
+#endif
+
+/**
+ * @brief picks the widest ascii run kernel the running CPU supports,
+ * AsciiPrefix is the fallback for any other CPU
+ * @return the kernel to find ascii runs with
+ */
+AsciiKernel SelectAsciiKernel(void) {
+#ifdef HAS_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return AsciiPrefixAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return AsciiPrefixSse2;
+    }
+#endif
+    return AsciiPrefix;
+}
+
+/**
+ * @brief starts a multibyte sequence - sets how many continuation bytes
+ * follow a lead byte, and the range of the first one, which rules out
+ * overlong forms, surrogates and code points past U+10FFFF
+ * @param state the validation state
+ * @param lead the lead byte, >= 0x80
+ * @return true if the byte can lead a sequence, else false
+ */
+bool Utf8Lead(Utf8State *state, unsigned char lead) {
+    state->low = UTF8_CONTINUATION_MIN;
+    state->high = UTF8_CONTINUATION_MAX;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        state->pending = 1;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        state->pending = 2;
+        if (lead == 0xe0) {
+            state->low = 0xa0;
+        } else if (lead == 0xed) {
+            state->high = 0x9f;
+        }
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        state->pending = 3;
+        if (lead == 0xf0) {
+            state->low = 0x90;
+        } else if (lead == 0xf4) {
+            state->high = 0x8f;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief validates the next bytes of a UTF-8 text, a sequence may go on in
+ * the next block. Ascii runs are skipped by the ascii kernel, a pure ascii
+ * block costs one vector pass. After the first invalid byte nothing more is
+ * checked.
+ * @param state the validation state, updated
+ * @param ascii_prefix the ascii run kernel
+ * @param in the bytes to validate
+ * @param len number of bytes in the block
+ */
+void Utf8Update(Utf8State *state, AsciiKernel ascii_prefix,
+                const unsigned char *in, size_t len) {
+    size_t i = 0;
+    while (state->is_valid && i < len) {
+        if (state->pending == 0) {
+            i += ascii_prefix(in + i, len - i);
+            if (i == len) {
+                break;
+            }
+            state->is_valid = Utf8Lead(state, in[i]);
+            state->sequence_start = state->offset + i;
+        } else if (in[i] >= state->low && in[i] <= state->high) {
+            state->low = UTF8_CONTINUATION_MIN;
+            state->high = UTF8_CONTINUATION_MAX;
+            state->pending--;
+        } else {
+            state->is_valid = false;
+        }
+        if (state->is_valid) {
+            i++;
+        }
+    }
+    state->offset += i;
+}
+
+/**
+ * @brief prepares a cipher context that encodes or decodes with the given
+ * shift number k, the translation table is built here once per key when
+ * use_table is set
+ * @param context the context to prepare
+ * @param mode whether the context encodes or decodes
+ * @param k the shifting number to encode or decode with
+ * @param use_table true to map the bytes through a translation table
+ */
+void CipherInit(CipherContext *context, CipherMode mode, int k,
+                bool use_table) {
+    context->shift_k = k % ENGLISH_LETTERS_NUM;
+    if (mode == CIPHER_DECODE) {
+        //decoding is encoding with the complementing shift, as in DecodeChar
+        context->shift_k = (ENGLISH_LETTERS_NUM - context->shift_k) %
+                ENGLISH_LETTERS_NUM;
+    }
+    context->shift_kernel = SelectShiftKernel();
+    context->use_key = false;
+    context->use_table = use_table;
+    context->table_kernel = SelectTableKernel();
+    if (use_table) {
+        BuildShiftTable(context->table, context->shift_k);
+    }
+    context->use_crc = false;
+    context->crc_kernel = SelectCrcKernel();
+    context->input_crc = 0;
+    context->output_crc = 0;
+    context->use_utf8 = false;
+    context->ascii_kernel = SelectAsciiKernel();
+    memset(&context->utf8, 0, sizeof(context->utf8));
+    context->utf8.is_valid = true;
+}
+
+/**
+ * @brief prepares a vigenere cipher context - the i-th letter of the text is
+ * shifted by the alphabet index of the (i mod key length)-th letter of the
+ * key word, so "b" is the same as k = 1. Other bytes are kept and do not
+ * take a letter of the key.
+ * @param context the context to prepare
+ * @param mode whether the context encodes or decodes
+ * @param key the key word, letters of any case
+ * @return true on success, false if the key is empty, longer than
+ * MAX_KEY_LEN or has other bytes than letters
+ */
+bool CipherInitKey(CipherContext *context, CipherMode mode, const char *key) {
+    size_t key_len = strlen(key);
+    if (key_len == 0 || key_len > MAX_KEY_LEN) {
+        return false;
+    }
+    for (size_t i = 0; i < key_len; i++) {
+        if (IsLetter((unsigned char) key[i]) == false) {
+            return false;
+        }
+    }
+    CipherInit(context, mode, 0, false);
+    //repeated over the whole stream, so the vector kernels can load their
+    //shifts from past the key length
+    for (size_t i = 0; i < MAX_KEY_LEN + KEY_STREAM_PAD; i++) {
+        int index = (key[i % key_len] | CASE_BIT) - LOWER_CASE_MIN;
+        if (mode == CIPHER_DECODE) {
+            index = (ENGLISH_LETTERS_NUM - index) % ENGLISH_LETTERS_NUM;
+        }
+        context->key_stream[i] = (unsigned char) index;
+    }
+    context->use_key = true;
+    context->key_len = key_len;
+    context->key_pos = 0;
+    context->key_kernel = SelectKeyKernel();
+    return true;
+}
+
+/**
+ * @brief prepares a cipher context from the options - with the vigenere key
+ * when one is given, else with the shift number k
+ * @param context the context to prepare
+ * @param mode whether the context encodes or decodes
+ * @param k the shifting number, used without a key
+ * @param options the options holding the key and the table mode
+ * @return true on success, false if the key is invalid
+ */
+bool CipherPrepare(CipherContext *context, CipherMode mode, int k,
+                   const CipherOptions *options) {
+    if (options->key == NULL) {
+        CipherInit(context, mode, k, options->use_table);
+    } else if (CipherInitKey(context, mode, options->key) == false) {
+        fprintf(stderr, ERROR_KEY);
+        return false;
+    }
+    context->use_crc = options->use_crc;
+    context->use_utf8 = options->use_utf8;
+    return true;
+}
+
+/**
+ * @brief transforms a buffer with the kernel of a prepared context, without
+ * the checksums
+ * @param context the prepared cipher context
+ * @param in the bytes to transform
+ * @param out where to put the transformed bytes
+ * @param len number of bytes in the buffer
+ */
+void CipherTransform(CipherContext *context, const unsigned char *in,
+                     unsigned char *out, size_t len) {
+    if (context->use_key) {
+        context->key_kernel(in, out, len, context->key_stream,
+                            context->key_len, &context->key_pos);
+    } else if (context->use_table) {
+        context->table_kernel(in, out, len, context->table);
+    } else {
+        context->shift_kernel(in, out, len, context->shift_k);
+    }
+}
+
+/**
+ * @brief transforms a buffer with a prepared context, in may be equal to out
+ * to transform it in place. Buffers of a stream may be given one after
+ * another in any sizes. With use_crc the checksums of the input and the
+ * output, and with use_utf8 the validation of the input, are updated in the
+ * same pass, piece by piece while it is in the L1 cache. Every buffer is
+ * counted in the process wide transform counters.
+ * @param context the prepared cipher context
+ * @param in the bytes to transform
+ * @param out where to put the transformed bytes
+ * @param len number of bytes in the buffer
+ */
+void CipherUpdate(CipherContext *context, const unsigned char *in,
+                  unsigned char *out, size_t len) {
+    __atomic_fetch_add(&transform_counters.blocks, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&transform_counters.bytes, len, __ATOMIC_RELAXED);
+    if (context->use_crc == false && context->use_utf8 == false) {
+        CipherTransform(context, in, out, len);
+        return;
+    }
+    for (size_t done = 0; done < len; done += FUSE_LEN) {
+        size_t piece = len - done < FUSE_LEN ? len - done : FUSE_LEN;
+        if (context->use_utf8) {
+            Utf8Update(&context->utf8, context->ascii_kernel, in + done,
+                       piece);
+        }
+        if (context->use_crc) {
+            context->input_crc = context->crc_kernel(context->input_crc,
+                                                     in + done, piece);
+        }
+        CipherTransform(context, in + done, out + done, piece);
+        if (context->use_crc) {
+            context->output_crc = context->crc_kernel(context->output_crc,
+                                                      out + done, piece);
+        }
+    }
+}
+
+/**
+ * @brief streaming engine - reads the input in blocks, shifts every block as
+ * a whole and writes it to the output. The files should be unbuffered, so
+ * blocks go straight between them and the block buffer.
+ * @param input the input file to shift
+ * @param output the output file to put the shifted text
+ * @param context the cipher context applied to every block
+ * @param block buffer of block_size bytes to read the blocks into
+ * @param block_size number of bytes read and written at once
+ * @return true on success, false if an I/O error occurred
+ */
+bool StreamBlocks(FILE **input, FILE **output, CipherContext *context,
+                  unsigned char *block, size_t block_size) {
+    bool is_valid = true;
+    size_t read_len;
+    while ((read_len = fread(block, 1, block_size, *input)) > 0) {
+        CipherUpdate(context, block, block, read_len);
+        if (fwrite(block, 1, read_len, *output) != read_len) {
+            is_valid = false;
+            break;
+        }
+    }
+    if (ferror(*input)) {
+        is_valid = false;
+    }
+    return is_valid;
+}
+
+/**
+ * @brief streaming engine with its own block buffer
+ * @param input the input file to shift
+ * @param output the output file to put the shifted text
+ * @param context the cipher context applied to every block
+ * @param block_size number of bytes read and written at once
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool StreamInput(FILE **input, FILE **output, CipherContext *context,
+                 size_t block_size) {
+    unsigned char *block = (unsigned char *) malloc(block_size);
+    if (block == NULL) {
+        fprintf(stderr, ERROR_ALLOC);
+        return false;
+    }
+    //blocks go straight between the files and our buffer, no stdio copies
+    setvbuf(*input, NULL, _IONBF, 0);
+    setvbuf(*output, NULL, _IONBF, 0);
+    bool is_valid = StreamBlocks(input, output, context, block, block_size);
+    if (is_valid == false) {
+        fprintf(stderr, ERROR_IO);
+    }
+    free(block);
+    return is_valid;
+}
+
+/**
+ * @brief fills options for a streaming run with blocks of DEFAULT_BLOCK_SIZE
+ * and the default number of threads
+ * @param options the options to fill
+ */
+void CipherDefaultOptions(CipherOptions *options) {
+    options->block_size = DEFAULT_BLOCK_SIZE;
+    options->use_table = false;
+    options->use_mmap = false;
+    options->use_uring = false;
+    options->use_frames = false;
+    options->frame_size = DEFAULT_FRAME_SIZE;
+    options->use_range = false;
+    options->use_watch = false;
+    options->use_crc = false;
+    options->use_utf8 = false;
+    options->range_start = 0;
+    options->range_len = 0;
+    options->threads = 0;
+    options->key = NULL;
+}
+
+/**
+ * @brief checks whether an open file is a regular file, which unlike pipes
+ * and devices can be mapped to memory
+ * @param file the file to check
+ * @return true if the file is a regular file, else false
+ */
+bool IsRegularFile(FILE *file) {
+    struct stat file_stat;
+    return fstat(fileno(file), &file_stat) == 0 && S_ISREG(file_stat.st_mode);
+}
+
+/**
+ * @brief zero copy engine - maps the input file read only, sizes and maps
+ * the output file, then transforms directly from one mapping into the other
+ * @param input the regular input file to shift
+ * @param output the regular output file to put the shifted text
+ * @param context the cipher context applied to the input
+ * @return true on success, false if an I/O error occurred
+ */
+bool MapInput(FILE **input, FILE **output, CipherContext *context) {
+    struct stat input_stat;
+    int input_fd = fileno(*input);
+    int output_fd = fileno(*output);
+    if (fstat(input_fd, &input_stat) != 0 ||
+        ftruncate(output_fd, input_stat.st_size) != 0) {
+        fprintf(stderr, ERROR_IO);
+        return false;
+    }
+    size_t len = (size_t) input_stat.st_size;
+    if (len == 0) {
+        return true;
+    }
+    unsigned char *source = mmap(NULL, len, PROT_READ, MAP_SHARED, input_fd,
+                                 0);
+    if (source == MAP_FAILED) {
+        fprintf(stderr, ERROR_IO);
+        return false;
+    }
+    unsigned char *dest = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                               output_fd, 0);
+    if (dest == MAP_FAILED) {
+        munmap(source, len);
+        fprintf(stderr, ERROR_IO);
+        return false;
+    }
+    //both mappings are walked once from start to end
+    madvise(source, len, MADV_SEQUENTIAL);
+    madvise(dest, len, MADV_SEQUENTIAL);
+    CipherUpdate(context, source, dest, len);
+    munmap(dest, len);
+    munmap(source, len);
+    return true;
+}
+
+/**
+ * @brief worker thread - encodes one chunk of the input block by block with
+ * pread/pwrite at the chunk's own offsets
+ * @param arg the ChunkJob to run, is_valid is set to the result
+ * @return NULL
+ */
+void *EncodeChunk(void *arg) {
+    ChunkJob *job = (ChunkJob *) arg;
+    unsigned char *block = (unsigned char *) malloc(job->block_size);
+    off_t offset = job->start;
+    job->is_valid = block != NULL;
+    while (job->is_valid && offset < job->end) {
+        size_t want = job->block_size;
+        if ((off_t) want > job->end - offset) {
+            want = (size_t) (job->end - offset);
+        }
+        ssize_t read_len = pread(job->input_fd, block, want, offset);
+        if (read_len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read_len <= 0) {
+            //the input was cut short while encoding or could not be read
+            job->is_valid = false;
+            break;
+        }
+        CipherUpdate(&job->context, block, block, (size_t) read_len);
+        for (ssize_t written = 0; written < read_len;) {
+            ssize_t write_len = pwrite(job->output_fd, block + written,
+                                       (size_t) (read_len - written),
+                                       offset + written);
+            if (write_len < 0 && errno != EINTR) {
+                job->is_valid = false;
+                break;
+            }
+            written += write_len > 0 ? write_len : 0;
+        }
+        offset += read_len;
+    }
+    free(block);
+    return NULL;
+}
+
+/**
+ * @brief multi threaded engine - splits a regular input file into page
+ * aligned chunks, and encodes every chunk on its own worker thread
+ * @param input the regular input file to shift
+ * @param output the regular output file to put the shifted text
+ * @param context the cipher context applied to the input
+ * @param options the run time options
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool ThreadedInput(FILE **input, FILE **output, CipherContext *context,
+                   const CipherOptions *options) {
+    struct stat input_stat;
+    bool is_valid = true;
+    int input_fd = fileno(*input);
+    int output_fd = fileno(*output);
+    if (fstat(input_fd, &input_stat) != 0 ||
+        ftruncate(output_fd, input_stat.st_size) != 0) {
+        fprintf(stderr, ERROR_IO);
+        return false;
+    }
+    //the key position of a vigenere chunk depends on all letters before it,
+    //and a UTF-8 sequence may cross the start of a chunk
+    off_t num_chunks = options->threads > 1 && context->use_key == false &&
+            context->use_utf8 == false ? (off_t) options->threads : 1;
+    off_t chunk_len = input_stat.st_size / num_chunks + 1;
+    chunk_len = (chunk_len + CHUNK_ALIGN - 1) / CHUNK_ALIGN * CHUNK_ALIGN;
+    size_t num_jobs = (size_t) ((input_stat.st_size + chunk_len - 1) /
+            chunk_len);
+    ChunkJob *jobs = (ChunkJob *) calloc(num_jobs + 1, sizeof(ChunkJob));
+    pthread_t *threads = (pthread_t *) calloc(num_jobs + 1,
+                                              sizeof(pthread_t));
+    bool *is_started = (bool *) calloc(num_jobs + 1, sizeof(bool));
+    if (jobs == NULL || threads == NULL || is_started == NULL) {
+        free(jobs);
+        free(threads);
+        free(is_started);
+        fprintf(stderr, ERROR_ALLOC);
+        return false;
+    }
+    for (size_t i = 0; i < num_jobs; i++) {
+        jobs[i].input_fd = input_fd;
+        jobs[i].output_fd = output_fd;
+        jobs[i].start = (off_t) i * chunk_len;
+        jobs[i].end = jobs[i].start + chunk_len < input_stat.st_size ?
+                jobs[i].start + chunk_len : input_stat.st_size;
+        //every chunk has its own checksums, combined in order at the end
+        jobs[i].context = *context;
+        jobs[i].context.input_crc = 0;
+        jobs[i].context.output_crc = 0;
+        jobs[i].block_size = options->block_size;
+        is_started[i] = pthread_create(&threads[i], NULL, EncodeChunk,
+                                       &jobs[i]) == 0;
+        if (is_started[i] == false) {
+            //no thread left for this chunk, encode it here
+            EncodeChunk(&jobs[i]);
+        }
+    }
+    for (size_t i = 0; i < num_jobs; i++) {
+        if (is_started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        is_valid = is_valid && jobs[i].is_valid;
+        unsigned long long chunk_len = (unsigned long long) (jobs[i].end -
+                jobs[i].start);
+        context->input_crc = Crc32cCombine(context->input_crc,
+                                           jobs[i].context.input_crc,
+                                           chunk_len);
+        context->output_crc = Crc32cCombine(context->output_crc,
+                                            jobs[i].context.output_crc,
+                                            chunk_len);
+    }
+    if (num_jobs == 1) {
+        //a single chunk carries the vigenere key position and the UTF-8
+        //validation on
+        context->key_pos = jobs[0].context.key_pos;
+        context->utf8 = jobs[0].context.utf8;
+    }
+    if (is_valid == false) {
+        fprintf(stderr, ERROR_IO);
+    }
+    free(jobs);
+    free(threads);
+    free(is_started);
+    return is_valid;
+}
+
+#ifdef HAS_IO_URING
+/**
+ * @brief unmaps the rings of an io_uring instance and closes it, the rings
+ * not mapped yet are NULL
+ * @param ring the instance to close
+ */
+void UringClose(UringRing *ring) {
+    if (ring->sqes != NULL) {
+        munmap(ring->sqes, ring->sqes_len);
+    }
+    if (ring->cq_ring != NULL && ring->cq_ring != ring->sq_ring) {
+        munmap(ring->cq_ring, ring->cq_ring_len);
+    }
+    if (ring->sq_ring != NULL) {
+        munmap(ring->sq_ring, ring->sq_ring_len);
+    }
+    close(ring->fd);
+}
+
+/**
+ * @brief maps a ring of an io_uring instance into this process
+ * @param ring_fd the io_uring instance
+ * @param len size of the ring
+ * @param offset which ring to map
+ * @return the mapped ring, NULL if the mapping failed
+ */
+void *UringMap(int ring_fd, size_t len, off_t offset) {
+    void *ring = mmap(NULL, len, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+    return ring == MAP_FAILED ? NULL : ring;
+}
+
+/**
+ * @brief sets up an io_uring instance and maps its rings
+ * @param ring the instance to set up
+ * @param entries number of submission queue entries
+ * @return true on success, false if io_uring is not available
+ */
+bool UringSetup(UringRing *ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = (int) syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0) {
+        return false;
+    }
+    ring->sq_ring_len = params.sq_off.array +
+            params.sq_entries * sizeof(unsigned);
+    ring->cq_ring_len = params.cq_off.cqes +
+            params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        //both rings share one mapping
+        if (ring->cq_ring_len > ring->sq_ring_len) {
+            ring->sq_ring_len = ring->cq_ring_len;
+        }
+        ring->sq_ring = UringMap(ring->fd, ring->sq_ring_len,
+                                 IORING_OFF_SQ_RING);
+        ring->cq_ring = ring->sq_ring;
+    } else {
+        ring->sq_ring = UringMap(ring->fd, ring->sq_ring_len,
+                                 IORING_OFF_SQ_RING);
+        ring->cq_ring = UringMap(ring->fd, ring->cq_ring_len,
+                                 IORING_OFF_CQ_RING);
+    }
+    ring->sqes = UringMap(ring->fd, ring->sqes_len, IORING_OFF_SQES);
+    if (ring->sq_ring == NULL || ring->cq_ring == NULL || ring->sqes == NULL) {
+        UringClose(ring);
+        return false;
+    }
+    unsigned char *sq_ring = (unsigned char *) ring->sq_ring;
+    unsigned char *cq_ring = (unsigned char *) ring->cq_ring;
+    ring->sq_tail = (unsigned *) (sq_ring + params.sq_off.tail);
+    ring->sq_mask = (unsigned *) (sq_ring + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *) (sq_ring + params.sq_off.array);
+    ring->cq_head = (unsigned *) (cq_ring + params.cq_off.head);
+    ring->cq_tail = (unsigned *) (cq_ring + params.cq_off.tail);
+    ring->cq_mask = (unsigned *) (cq_ring + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (cq_ring + params.cq_off.cqes);
+    return true;
+}
+
+/**
+ * @brief queues a read or write of the part of a slot's block not done yet,
+ * it is submitted by the next UringWait
+ * @param ring the io_uring instance
+ * @param slots the slots of the engine
+ * @param index index of the slot in slots
+ * @param fd the file to read or write
+ * @param opcode IORING_OP_READ or IORING_OP_WRITE
+ */
+void UringQueue(UringRing *ring, const UringSlot *slots, size_t index, int fd,
+                unsigned char opcode) {
+    const UringSlot *slot = &slots[index];
+    unsigned tail = *ring->sq_tail;
+    unsigned entry = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[entry];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long long) (uintptr_t) (slot->block + slot->done);
+    sqe->len = (unsigned) (slot->len - slot->done);
+    sqe->off = (unsigned long long) slot->offset + slot->done;
+    sqe->user_data = index;
+    ring->sq_array[entry] = entry;
+    //the entry must be filled before the kernel sees the new tail
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->to_submit++;
+}
+
+/**
+ * @brief submits the queued requests and waits for at least one completion
+ * @param ring the io_uring instance
+ * @return true on success, false if the system call failed
+ */
+bool UringWait(UringRing *ring) {
+    for (;;) {
+        long submitted = syscall(__NR_io_uring_enter, ring->fd,
+                                 ring->to_submit, 1, IORING_ENTER_GETEVENTS,
+                                 NULL, 0);
+        if (submitted >= 0) {
+            ring->to_submit -= (unsigned) submitted;
+            return true;
+        }
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief io_uring engine - a pipeline of URING_DEPTH blocks, so reads of the
+ * next blocks and writes of the previous blocks are in flight while a block
+ * is transformed. Blocks are read and written at their own offsets, and
+ * transformed in file order for the vigenere key position. Falls back to
+ * blocking pread/pwrite when io_uring can not be set up.
+ * @param input the regular input file to shift
+ * @param output the regular output file to put the shifted text, may be the
+ * input
+ * @param context the cipher context applied to the input
+ * @param options the run time options
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool UringInput(FILE **input, FILE **output, CipherContext *context,
+                const CipherOptions *options) {
+    UringRing ring;
+    if (UringSetup(&ring, URING_DEPTH) == false) {
+        return ThreadedInput(input, output, context, options);
+    }
+    struct stat input_stat;
+    int input_fd = fileno(*input);
+    int output_fd = fileno(*output);
+    if (fstat(input_fd, &input_stat) != 0 ||
+        ftruncate(output_fd, input_stat.st_size) != 0) {
+        UringClose(&ring);
+        fprintf(stderr, ERROR_IO);
+        return false;
+    }
+    UringSlot slots[URING_DEPTH];
+    unsigned char *blocks = (unsigned char *) malloc(URING_DEPTH *
+                                                     options->block_size);
+    if (blocks == NULL) {
+        UringClose(&ring);
+        fprintf(stderr, ERROR_ALLOC);
+        return false;
+    }
+    for (size_t i = 0; i < URING_DEPTH; i++) {
+        slots[i].block = blocks + i * options->block_size;
+        slots[i].stage = URING_FREE;
+    }
+    bool is_valid = true;
+    off_t next_offset = 0;
+    size_t next_read = 0;
+    size_t next_transform = 0;
+    size_t in_flight = 0;
+    for (;;) {
+        //block i always goes to slot i % URING_DEPTH
+        while (is_valid && next_offset < input_stat.st_size &&
+               slots[next_read % URING_DEPTH].stage == URING_FREE) {
+            UringSlot *slot = &slots[next_read % URING_DEPTH];
+            slot->offset = next_offset;
+            slot->len = options->block_size;
+            if ((off_t) slot->len > input_stat.st_size - next_offset) {
+                slot->len = (size_t) (input_stat.st_size - next_offset);
+            }
+            slot->done = 0;
+            slot->stage = URING_READING;
+            UringQueue(&ring, slots, next_read % URING_DEPTH, input_fd,
+                       IORING_OP_READ);
+            next_offset += (off_t) slot->len;
+            next_read++;
+            in_flight++;
+        }
+        while (is_valid && next_transform < next_read &&
+               slots[next_transform % URING_DEPTH].stage == URING_READ_DONE) {
+            UringSlot *slot = &slots[next_transform % URING_DEPTH];
+            CipherUpdate(context, slot->block, slot->block, slot->len);
+            slot->done = 0;
+            slot->stage = URING_WRITING;
+            UringQueue(&ring, slots, next_transform % URING_DEPTH, output_fd,
+                       IORING_OP_WRITE);
+            next_transform++;
+            in_flight++;
+        }
+        if (in_flight == 0) {
+            break;
+        }
+        if (UringWait(&ring) == false) {
+            //the blocks may still be in use by the kernel
+            is_valid = false;
+            blocks = NULL;
+            break;
+        }
+        unsigned head = *ring.cq_head;
+        unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+            size_t index = (size_t) cqe->user_data;
+            UringSlot *slot = &slots[index];
+            int fd = slot->stage == URING_READING ? input_fd : output_fd;
+            unsigned char opcode = slot->stage == URING_READING ?
+                    IORING_OP_READ : IORING_OP_WRITE;
+            if (cqe->res == -EINTR || cqe->res == -EAGAIN) {
+                UringQueue(&ring, slots, index, fd, opcode);
+                continue;
+            }
+            if (cqe->res <= 0) {
+                //the input was cut short while encoding or could not be read
+                is_valid = false;
+                slot->stage = URING_FREE;
+                in_flight--;
+                continue;
+            }
+            slot->done += (size_t) cqe->res;
+            if (slot->done < slot->len) {
+                UringQueue(&ring, slots, index, fd, opcode);
+                continue;
+            }
+            slot->stage = slot->stage == URING_READING ?
+                    URING_READ_DONE : URING_FREE;
+            in_flight--;
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+    UringClose(&ring);
+    if (is_valid == false) {
+        fprintf(stderr, ERROR_IO);
+    }
+    free(blocks);
+    return is_valid;
+}
+#endif
+
+/**
+ * @brief checks whether two paths name the same regular file
+ * @param first_path the first path to check
+ * @param second_path the second path to check
+ * @return true if both are the same regular file, else false
+ */
+bool IsSameFile(const char *first_path, const char *second_path) {
+    struct stat first_stat;
+    struct stat second_stat;
+    if (stat(first_path, &first_stat) != 0 ||
+        stat(second_path, &second_stat) != 0) {
+        return false;
+    }
+    return S_ISREG(first_stat.st_mode) &&
+            first_stat.st_dev == second_stat.st_dev &&
+            first_stat.st_ino == second_stat.st_ino;
+}
+
+/**
+ * @brief transforms the input into the output with the engine the options
+ * select - when both files are regular, worker threads if more than one is
+ * asked for, io_uring or mapped files if asked for, otherwise streaming.
+ * In place, when input and output are the same file, every block is read,
+ * transformed and written back to its own offset with pwrite.
+ * @param input the input file to shift
+ * @param output the output file to put the shifted text, may be the input
+ * @param context the cipher context applied to the input
+ * @param options the run time options
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool SelectEngine(FILE **input, FILE **output, CipherContext *context,
+                  const CipherOptions *options) {
+    bool is_regular = IsRegularFile(*input) && IsRegularFile(*output);
+    if (options->threads > 1 && is_regular) {
+        return ThreadedInput(input, output, context, options);
+    }
+#ifdef HAS_IO_URING
+    if (options->use_uring && is_regular) {
+        return UringInput(input, output, context, options);
+    }
+#endif
+    if (options->use_mmap && is_regular) {
+        return MapInput(input, output, context);
+    }
+    if (*input == *output) {
+        return ThreadedInput(input, output, context, options);
+    }
+    return StreamInput(input, output, context, options->block_size);
+}
+
+/**
+ * @brief transforms the input into the output with the engine the options
+ * select, see SelectEngine. With use_utf8 the input must also be valid UTF-8
+ * through to its end, else the byte offset of the first invalid sequence is
+ * printed - the output is still written in full.
+ * @param input the input file to shift
+ * @param output the output file to put the shifted text, may be the input
+ * @param context the cipher context applied to the input
+ * @param options the run time options
+ * @return true on success, false if the input is not valid UTF-8, or an
+ * allocation or I/O error occurred
+ */
+bool ProcessInput(FILE **input, FILE **output, CipherContext *context,
+                  const CipherOptions *options) {
+    if (SelectEngine(input, output, context, options) == false) {
+        return false;
+    }
+    //a sequence cut short, by a bad byte or by the end of the input, is
+    //reported where it starts
+    const Utf8State *utf8 = &context->utf8;
+    if (context->use_utf8 && (utf8->is_valid == false || utf8->pending > 0)) {
+        fprintf(stderr, ERROR_UTF8,
+                utf8->pending > 0 ? utf8->sequence_start : utf8->offset);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief fills the CRC32C lookup table, run once by pthread_once
+ */
+void BuildCrc32cTable(void) {
+    for (unsigned i = 0; i < TABLE_SIZE; i++) {
+        unsigned crc = i;
+        for (int bit = 0; bit < CHAR_BIT; bit++) {
+            crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        }
+        crc32c_table[i] = crc;
+    }
+}
+
+/**
+ * @brief adds a buffer to a CRC32C (Castagnoli) checksum
+ * @param crc the checksum of the bytes before the buffer, 0 to start
+ * @param in the bytes to add
+ * @param len number of bytes in the buffer
+ * @return the checksum including the buffer
+ */
+unsigned Crc32c(unsigned crc, const unsigned char *in, size_t len) {
+    pthread_once(&crc32c_table_once, BuildCrc32cTable);
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = crc32c_table[(crc ^ in[i]) & 0xff] ^ (crc >> CHAR_BIT);
+    }
+    return ~crc;
+}
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief Crc32c with the crc32 instruction, 8 bytes at a time - the caller
+ * must check the CPU supports SSE4.2
+ */
+__attribute__((target("sse4.2")))
+unsigned Crc32cSse42(unsigned crc, const unsigned char *in, size_t len) {
+    size_t i = 0;
+    crc = ~crc;
+#ifdef __x86_64__
+    unsigned long long wide_crc = crc;
+    for (; i + sizeof(unsigned long long) <= len;
+         i += sizeof(unsigned long long)) {
+        unsigned long long word;
+        memcpy(&word, in + i, sizeof(word));
+        wide_crc = _mm_crc32_u64(wide_crc, word);
+    }
+    crc = (unsigned) wide_crc;
+#endif
+    for (; i + sizeof(unsigned) <= len; i += sizeof(unsigned)) {
+        unsigned word;
+        memcpy(&word, in + i, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; i < len; i++) {
+        crc = _mm_crc32_u8(crc, in[i]);
+    }
+    return ~crc;
+}
+#endif
+
+/**
+ * @brief picks the crc32 instruction when the running CPU has it, Crc32c is
+ * the fallback for any other CPU
+ * @return the kernel to checksum blocks with
+ */
+CrcKernel SelectCrcKernel(void) {
+#ifdef HAS_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        return Crc32cSse42;
+    }
+#endif
+    return Crc32c;
+}
+
+/**
+ * @brief multiplies two polynomials modulo the CRC32C polynomial, both in
+ * the reflected bit order of the checksum - bit 31 is x^0
+ * @param first the first polynomial
+ * @param second the second polynomial
+ * @return the product modulo the polynomial
+ */
+unsigned MultiplyModCrc32c(unsigned first, unsigned second) {
+    unsigned product = 0;
+    for (unsigned bit = 1u << (CRC_BITS - 1); bit != 0; bit >>= 1) {
+        if (first & bit) {
+            product ^= second;
+        }
+        //second times x
+        second = second & 1 ? (second >> 1) ^ CRC32C_POLY : second >> 1;
+    }
+    return product;
+}
+
+/**
+ * @brief combines the checksums of two consecutive buffers into the
+ * checksum of both - the first checksum is moved past the second buffer by
+ * multiplying it with x^(8 * second_len)
+ * @param first_crc the checksum of the first buffer
+ * @param second_crc the checksum of the second buffer
+ * @param second_len number of bytes in the second buffer
+ * @return the checksum of the first buffer followed by the second
+ */
+unsigned Crc32cCombine(unsigned first_crc, unsigned second_crc,
+                       unsigned long long second_len) {
+    //x^0, and x^8 to be squared for every bit of the length
+    unsigned shift = 1u << (CRC_BITS - 1);
+    unsigned power = 1u << (CRC_BITS - 1 - CHAR_BIT);
+    for (; second_len > 0; second_len >>= 1) {
+        if (second_len & 1) {
+            shift = MultiplyModCrc32c(power, shift);
+        }
+        power = MultiplyModCrc32c(power, power);
+    }
+    return MultiplyModCrc32c(shift, first_crc) ^ second_crc;
+}
+
+/**
+ * @brief stores a number as little endian bytes
+ * @param dest where to store the bytes
+ * @param value the number to store
+ * @param len number of bytes to store
+ */
+void StoreLittleEndian(unsigned char *dest, unsigned long long value,
+                       size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dest[i] = (unsigned char) (value >> (i * CHAR_BIT));
+    }
+}
+
+/**
+ * @brief loads a number stored as little endian bytes
+ * @param src the bytes to load
+ * @param len number of bytes to load
+ * @return the number
+ */
+unsigned long long LoadLittleEndian(const unsigned char *src, size_t len) {
+    unsigned long long value = 0;
+    for (size_t i = 0; i < len; i++) {
+        value |= (unsigned long long) src[i] << (i * CHAR_BIT);
+    }
+    return value;
+}
+
+/**
+ * @brief framed encoding engine - writes the frame file header, then encodes
+ * the input frame by frame. Every frame holds frame_size input bytes, the
+ * last one fewer, behind a header of its input offset, length, vigenere key
+ * position and the CRC32C of the encoded bytes.
+ * @param input the input file to encode, may be a pipe
+ * @param output the output file to put the frames, may be a pipe
+ * @param context the cipher context applied to the input
+ * @param options the run time options
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool FrameEncodeInput(FILE **input, FILE **output, CipherContext *context,
+                      const CipherOptions *options) {
+    if (*input == *output) {
+        fprintf(stderr, ERROR_FRAMES_IN_PLACE);
+        return false;
+    }
+    unsigned char header[FRAME_FILE_HEADER_LEN];
+    unsigned char *frame = (unsigned char *) malloc(FRAME_HEADER_LEN +
+                                                    options->frame_size);
+    if (frame == NULL) {
+        fprintf(stderr, ERROR_ALLOC);
+        return false;
+    }
+    memcpy(header, FRAME_MAGIC, FRAME_MAGIC_LEN);
+    StoreLittleEndian(header + FRAME_MAGIC_LEN, options->frame_size,
+                      FRAME_SIZE_LEN);
+    bool is_valid = fwrite(header, 1, FRAME_FILE_HEADER_LEN, *output) ==
+            FRAME_FILE_HEADER_LEN;
+    unsigned char *payload = frame + FRAME_HEADER_LEN;
+    unsigned long long offset = 0;
+    size_t read_len;
+    while (is_valid &&
+           (read_len = fread(payload, 1, options->frame_size, *input)) > 0) {
+        StoreLittleEndian(frame + FRAME_OFFSET_POS, offset, FRAME_OFFSET_LEN);
+        StoreLittleEndian(frame + FRAME_LENGTH_POS, read_len,
+                          FRAME_LENGTH_LEN);
+        StoreLittleEndian(frame + FRAME_KEY_POS_POS, context->key_pos,
+                          FRAME_KEY_POS_LEN);
+        CipherUpdate(context, payload, payload, read_len);
+        StoreLittleEndian(frame + FRAME_CRC_POS,
+                          context->crc_kernel(0, payload, read_len),
+                          FRAME_CRC_LEN);
+        is_valid = fwrite(frame, 1, FRAME_HEADER_LEN + read_len, *output) ==
+                FRAME_HEADER_LEN + read_len;
+        offset += read_len;
+    }
+    if (ferror(*input)) {
+        is_valid = false;
+    }
+    if (is_valid == false) {
+        fprintf(stderr, ERROR_IO);
+    }
+    free(frame);
+    return is_valid;
+}
+
+/**
+ * @brief reads up to len bytes at an offset, until the end of the file
+ * @param fd the file to read
+ * @param buffer where to put the bytes
+ * @param len number of bytes to read
+ * @param offset where in the file to read from
+ * @return number of bytes read, -1 if the file could not be read
+ */
+ssize_t ReadFull(int fd, unsigned char *buffer, size_t len, off_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t read_len = pread(fd, buffer + done, len - done,
+                                 offset + (off_t) done);
+        if (read_len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read_len < 0) {
+            return -1;
+        }
+        if (read_len == 0) {
+            break;
+        }
+        done += (size_t) read_len;
+    }
+    return (ssize_t) done;
+}
+
+/**
+ * @brief writes len bytes at an offset
+ * @param fd the file to write
+ * @param buffer the bytes to write
+ * @param len number of bytes to write
+ * @param offset where in the file to write to
+ * @return true on success, false if the file could not be written
+ */
+bool WriteFull(int fd, const unsigned char *buffer, size_t len,
+               off_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t write_len = pwrite(fd, buffer + done, len - done,
+                                   offset + (off_t) done);
+        if (write_len < 0 && errno != EINTR) {
+            return false;
+        }
+        done += write_len > 0 ? (size_t) write_len : 0;
+    }
+    return true;
+}
+
+/**
+ * @brief worker thread - decodes a run of frames, checks every frame's
+ * header and checksum, and writes the part of it inside the range - at its
+ * own offset with pwrite, or in order to the output stream when there is no
+ * output file descriptor
+ * @param arg the FrameJob to run, is_valid is set to the result
+ * @return NULL
+ */
+void *DecodeFrames(void *arg) {
+    FrameJob *job = (FrameJob *) arg;
+    unsigned char *frame = (unsigned char *) malloc(FRAME_HEADER_LEN +
+                                                    job->frame_size);
+    unsigned char *payload = frame + FRAME_HEADER_LEN;
+    job->is_valid = frame != NULL;
+    job->is_corrupt = false;
+    for (unsigned long long i = job->first_frame;
+         job->is_valid && i < job->end_frame; i++) {
+        off_t position = FRAME_FILE_HEADER_LEN +
+                (off_t) (i * (FRAME_HEADER_LEN + job->frame_size));
+        ssize_t read_len = ReadFull(job->input_fd, frame,
+                                    FRAME_HEADER_LEN + job->frame_size,
+                                    position);
+        if (read_len < 0) {
+            job->is_valid = false;
+            break;
+        }
+        if (read_len < FRAME_HEADER_LEN) {
+            job->is_corrupt = true;
+            job->is_valid = false;
+            break;
+        }
+        unsigned long long offset = LoadLittleEndian(frame + FRAME_OFFSET_POS,
+                                                     FRAME_OFFSET_LEN);
+        size_t len = (size_t) LoadLittleEndian(frame + FRAME_LENGTH_POS,
+                                               FRAME_LENGTH_LEN);
+        CipherContext context = *job->context;
+        context.key_pos = (size_t) LoadLittleEndian(frame + FRAME_KEY_POS_POS,
+                                                    FRAME_KEY_POS_LEN);
+        if ((size_t) read_len - FRAME_HEADER_LEN < len ||
+            offset != i * job->frame_size ||
+            (context.use_key && context.key_pos >= context.key_len) ||
+            context.crc_kernel(0, payload, len) !=
+            LoadLittleEndian(frame + FRAME_CRC_POS, FRAME_CRC_LEN)) {
+            job->is_corrupt = true;
+            job->is_valid = false;
+            break;
+        }
+        unsigned long long start = offset > job->range_start ?
+                offset : job->range_start;
+        unsigned long long end = offset + len < job->range_end ?
+                offset + len : job->range_end;
+        if (start >= end) {
+            continue;
+        }
+        //only the part of the frame inside the range is decoded
+        if (context.use_key) {
+            CipherUpdate(&context, payload, payload,
+                         (size_t) (start - offset));
+        }
+        unsigned char *slice = payload + (start - offset);
+        CipherUpdate(&context, slice, slice, (size_t) (end - start));
+        if (job->output_fd >= 0) {
+            job->is_valid = WriteFull(job->output_fd, slice,
+                                      (size_t) (end - start),
+                                      (off_t) (start - job->range_start));
+        } else {
+            job->is_valid = fwrite(slice, 1, (size_t) (end - start),
+                                   job->output) == end - start;
+        }
+    }
+    free(frame);
+    return NULL;
+}
+
+/**
+ * @brief framed decoding engine - decodes the frames of a regular file
+ * written by FrameEncodeInput. Frames are found by their index alone, so
+ * only the frames holding the range are read, and a regular output is
+ * written by several worker threads at once, each decoding its own run of
+ * frames.
+ * @param input the regular framed file to decode
+ * @param output the output file to put the decoded range
+ * @param context the cipher context applied to the frames
+ * @param options the run time options, the range and the threads
+ * @return true on success, false if the frames are invalid, or an
+ * allocation or I/O error occurred
+ */
+bool FrameDecodeInput(FILE **input, FILE **output, CipherContext *context,
+                      const CipherOptions *options) {
+    unsigned char header[FRAME_FILE_HEADER_LEN];
+    struct stat input_stat;
+    int input_fd = fileno(*input);
+    if (*input == *output) {
+        fprintf(stderr, ERROR_FRAMES_IN_PLACE);
+        return false;
+    }
+    if (IsRegularFile(*input) == false || fstat(input_fd, &input_stat) != 0 ||
+        ReadFull(input_fd, header, FRAME_FILE_HEADER_LEN, 0) !=
+        FRAME_FILE_HEADER_LEN ||
+        memcmp(header, FRAME_MAGIC, FRAME_MAGIC_LEN) != 0) {
+        fprintf(stderr, ERROR_FRAMES);
+        return false;
+    }
+    size_t frame_size = (size_t) LoadLittleEndian(header + FRAME_MAGIC_LEN,
+                                                  FRAME_SIZE_LEN);
+    unsigned long long body = (unsigned long long) input_stat.st_size -
+            FRAME_FILE_HEADER_LEN;
+    unsigned long long tail = body % (FRAME_HEADER_LEN + frame_size);
+    if (frame_size == 0 || frame_size > MAX_FRAME_SIZE ||
+        (tail > 0 && tail <= FRAME_HEADER_LEN)) {
+        fprintf(stderr, ERROR_FRAMES);
+        return false;
+    }
+    //every frame is full but the last one
+    unsigned long long num_frames = body / (FRAME_HEADER_LEN + frame_size);
+    unsigned long long total = num_frames * frame_size;
+    if (tail > 0) {
+        num_frames++;
+        total += tail - FRAME_HEADER_LEN;
+    }
+    unsigned long long range_start = 0;
+    unsigned long long range_end = total;
+    if (options->use_range) {
+        range_start = options->range_start < total ?
+                options->range_start : total;
+        range_end = options->range_len < total - range_start ?
+                range_start + options->range_len : total;
+    }
+    unsigned long long first_frame = range_start / frame_size;
+    unsigned long long end_frame = (range_end + frame_size - 1) / frame_size;
+    bool is_parallel = options->threads > 1 && IsRegularFile(*output);
+    size_t num_jobs = is_parallel ? options->threads : 1;
+    if (num_jobs > end_frame - first_frame) {
+        num_jobs = end_frame > first_frame ?
+                (size_t) (end_frame - first_frame) : 1;
+    }
+    if (is_parallel &&
+        ftruncate(fileno(*output), (off_t) (range_end - range_start)) != 0) {
+        fprintf(stderr, ERROR_IO);
+        return false;
+    }
+    FrameJob *jobs = (FrameJob *) calloc(num_jobs, sizeof(FrameJob));
+    pthread_t *threads = (pthread_t *) calloc(num_jobs, sizeof(pthread_t));
+    bool *is_started = (bool *) calloc(num_jobs, sizeof(bool));
+    if (jobs == NULL || threads == NULL || is_started == NULL) {
+        free(jobs);
+        free(threads);
+        free(is_started);
+        fprintf(stderr, ERROR_ALLOC);
+        return false;
+    }
+    unsigned long long frames_per_job = (end_frame - first_frame +
+            num_jobs - 1) / num_jobs;
+    for (size_t i = 0; i < num_jobs; i++) {
+        jobs[i].input_fd = input_fd;
+        jobs[i].output = *output;
+        jobs[i].output_fd = is_parallel ? fileno(*output) : -1;
+        jobs[i].frame_size = frame_size;
+        jobs[i].first_frame = first_frame + i * frames_per_job;
+        jobs[i].end_frame = jobs[i].first_frame + frames_per_job < end_frame ?
+                jobs[i].first_frame + frames_per_job : end_frame;
+        jobs[i].range_start = range_start;
+        jobs[i].range_end = range_end;
+        jobs[i].context = context;
+        //one job decodes here, writing to the output stream in order
+        is_started[i] = is_parallel &&
+                pthread_create(&threads[i], NULL, DecodeFrames, &jobs[i]) == 0;
+        if (is_started[i] == false) {
+            DecodeFrames(&jobs[i]);
+        }
+    }
+    bool is_valid = true;
+    bool is_corrupt = false;
+    for (size_t i = 0; i < num_jobs; i++) {
+        if (is_started[i]) {
+            pthread_join(threads[i], NULL);
+        }
+        is_valid = is_valid && jobs[i].is_valid;
+        is_corrupt = is_corrupt || jobs[i].is_corrupt;
+    }
+    if (is_valid == false) {
+        fprintf(stderr, is_corrupt ? ERROR_FRAMES : ERROR_IO);
+    }
+    free(jobs);
+    free(threads);
+    free(is_started);
+    return is_valid;
+}
+
+/**
+ * @brief enocoding main function - goes over the input file and encodes it
+ * @param input the input file to encode
+ * @param output the name of file to put the encoded text
+ * @param k the shift  number for encoding
+ * @param options the run time options
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool EncodeInput(FILE **input, FILE **output, int k,
+                 const CipherOptions *options) {
+    CipherContext context;
+    if (CipherPrepare(&context, CIPHER_ENCODE, k, options) == false) {
+        return false;
+    }
+    if (options->use_frames) {
+        return FrameEncodeInput(input, output, &context, options);
+    }
+    return ProcessInput(input, output, &context, options);
+}
+
+/**
+ * @brief decoding one char with the given shift k number, uses encode fucntion
+ * @param character the character to decode
+ * @param shiftK the shift number to decode
+ * @return the decoded character in DEC
+ */
+int DecodeChar(int character, int shift_k) {
+    shift_k %= ENGLISH_LETTERS_NUM;
+    return EncodeChar(character, ENGLISH_LETTERS_NUM - shift_k);
+}
+
+/**
+ * @brief main decoding function, gets input file and decodes it into output
+ * file
+ * @param input the input file to decode
+ * @param output the output file to output the decoded text to
+ * @param k the shifting number for decoding
+ * @param options the run time options
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool DecodeInput(FILE **input, FILE **output, int k,
+                 const CipherOptions *options) {
+    CipherContext context;
+    if (CipherPrepare(&context, CIPHER_DECODE, k, options) == false) {
+        return false;
+    }
+    if (options->use_frames) {
+        return FrameDecodeInput(input, output, &context, options);
+    }
+    return ProcessInput(input, output, &context, options);
+}
+
+/**
+ * @brief joins a directory and a file name into a new path
+ * @param dir the directory
+ * @param name the file name
+ * @return the allocated path, NULL if the allocation failed
+ */
+char *JoinPath(const char *dir, const char *name) {
+    char *path = (char *) malloc(strlen(dir) + strlen(PATH_SEPARATOR) +
+            strlen(name) + 1);
+    if (path != NULL) {
+        strcpy(path, dir);
+        strcat(path, PATH_SEPARATOR);
+        strcat(path, name);
+    }
+    return path;
+}
+
+/**
+ * @brief adds a job to a batch, the list owns the given paths from now on
+ * @param list the batch to add to
+ * @param input_path the allocated input path
+ * @param output_path the allocated output path
+ * @return true on success, false if an allocation failed - the paths are
+ * freed then
+ */
+bool AddBatchJob(BatchList *list, char *input_path, char *output_path) {
+    if (input_path != NULL && output_path != NULL &&
+        list->len == list->capacity) {
+        size_t capacity = list->capacity == 0 ? 1 : list->capacity * 2;
+        BatchJob *jobs = (BatchJob *) realloc(list->jobs,
+                                              capacity * sizeof(BatchJob));
+        if (jobs != NULL) {
+            list->jobs = jobs;
+            list->capacity = capacity;
+        }
+    }
+    if (input_path == NULL || output_path == NULL ||
+        list->len == list->capacity) {
+        free(input_path);
+        free(output_path);
+        fprintf(stderr, ERROR_ALLOC);
+        return false;
+    }
+    list->jobs[list->len].input_path = input_path;
+    list->jobs[list->len].output_path = output_path;
+    list->len++;
+    return true;
+}
+
+/**
+ * @brief frees the jobs of a batch and their paths
+ * @param list the batch to free
+ */
+void FreeBatchList(BatchList *list) {
+    for (size_t i = 0; i < list->len; i++) {
+        free(list->jobs[i].input_path);
+        free(list->jobs[i].output_path);
+    }
+    free(list->jobs);
+    list->jobs = NULL;
+    list->len = 0;
+    list->capacity = 0;
+}
+
+/**
+ * @brief lists every regular file of a directory as a job, written under the
+ * same name into the output directory
+ * @param source_dir the opened directory
+ * @param source_path path of the directory
+ * @param output_dir the directory to put the outputs in
+ * @param list the batch to add the jobs to
+ * @return true on success, false if an allocation failed
+ */
+bool ReadBatchDirectory(DIR *source_dir, const char *source_path,
+                        const char *output_dir, BatchList *list) {
+    struct dirent *entry;
+    struct stat entry_stat;
+    while ((entry = readdir(source_dir)) != NULL) {
+        char *input_path = JoinPath(source_path, entry->d_name);
+        if (input_path != NULL && (stat(input_path, &entry_stat) != 0 ||
+                                   !S_ISREG(entry_stat.st_mode))) {
+            free(input_path);
+            continue;
+        }
+        if (AddBatchJob(list, input_path,
+                        JoinPath(output_dir, entry->d_name)) == false) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief reads a manifest - every line holds an input path and an output
+ * path separated by white space, relative output paths are put under the
+ * output directory. Empty lines are skipped.
+ * @param manifest the opened manifest file
+ * @param output_dir the directory to put relative outputs in
+ * @param list the batch to add the jobs to
+ * @return true on success, false if a line is invalid or an allocation failed
+ */
+bool ReadBatchManifest(FILE *manifest, const char *output_dir,
+                       BatchList *list) {
+    char *line = NULL;
+    size_t line_capacity = 0;
+    bool is_valid = true;
+    while (is_valid && getline(&line, &line_capacity, manifest) != -1) {
+        char *save_ptr = NULL;
+        char *input_path = strtok_r(line, MANIFEST_DELIMS, &save_ptr);
+        char *output_path = strtok_r(NULL, MANIFEST_DELIMS, &save_ptr);
+        if (input_path == NULL) {
+            continue;
+        }
+        if (output_path == NULL || strtok_r(NULL, MANIFEST_DELIMS,
+                                            &save_ptr) != NULL) {
+            fprintf(stderr, ERROR_BATCH_SOURCE);
+            is_valid = false;
+            break;
+        }
+        is_valid = AddBatchJob(list, strdup(input_path),
+                               *output_path == *PATH_SEPARATOR ?
+                               strdup(output_path) :
+                               JoinPath(output_dir, output_path));
+    }
+    free(line);
+    return is_valid && ferror(manifest) == 0;
+}
+
+/**
+ * @brief transforms one file of a batch with the worker's block buffer
+ * @param job the job to run
+ * @param context a copy of the batch context for this file
+ * @param options the run time options
+ * @param block the worker's buffer of options->block_size bytes
+ * @return true on success, false if an I/O error occurred
+ */
+bool RunBatchJob(const BatchJob *job, CipherContext *context,
+                 const CipherOptions *options, unsigned char *block) {
+    bool is_valid;
+    if (IsSameFile(job->input_path, job->output_path)) {
+        FILE *file = fopen(job->input_path, "r+");
+        CipherOptions in_place_options = *options;
+        in_place_options.threads = 1;
+        is_valid = file != NULL && ProcessInput(&file, &file, context,
+                                                &in_place_options);
+        if (file != NULL) {
+            fclose(file);
+        }
+        return is_valid;
+    }
+    FILE *input = fopen(job->input_path, "r");
+    FILE *output = input == NULL ? NULL : fopen(job->output_path, "w");
+    if (output != NULL) {
+        setvbuf(input, NULL, _IONBF, 0);
+        setvbuf(output, NULL, _IONBF, 0);
+    }
+    is_valid = output != NULL && StreamBlocks(&input, &output, context, block,
+                                              options->block_size);
+    if (output != NULL && fclose(output) != 0) {
+        is_valid = false;
+    }
+    if (input != NULL) {
+        fclose(input);
+    }
+    return is_valid;
+}
+
+/**
+ * @brief batch worker thread - keeps one block buffer and runs the next job
+ * of the pool until no job is left
+ * @param arg the BatchPool shared by all workers
+ * @return NULL
+ */
+void *BatchWorker(void *arg) {
+    BatchPool *pool = (BatchPool *) arg;
+    unsigned char *block = (unsigned char *) malloc(
+            pool->options->block_size);
+    while (true) {
+        pthread_mutex_lock(&pool->lock);
+        size_t job_index = pool->next_job;
+        if (job_index < pool->list->len) {
+            pool->next_job++;
+        }
+        pthread_mutex_unlock(&pool->lock);
+        if (job_index >= pool->list->len) {
+            break;
+        }
+        const BatchJob *job = &pool->list->jobs[job_index];
+        //every file starts from the prepared context
+        CipherContext context = *pool->context;
+        if (block == NULL ||
+            RunBatchJob(job, &context, pool->options, block) == false) {
+            fprintf(stderr, ERROR_BATCH_FILE, job->input_path,
+                    job->output_path);
+            pthread_mutex_lock(&pool->lock);
+            pool->is_valid = false;
+            pthread_mutex_unlock(&pool->lock);
+        }
+    }
+    free(block);
+    return NULL;
+}
+
+/**
+ * @brief batch engine - transforms many files on a fixed pool of worker
+ * threads, every worker reuses one block buffer for all its files
+ * @param source_path a directory whose regular files are transformed, or a
+ * manifest file of input and output paths
+ * @param output_dir the directory to put the outputs in
+ * @param context the prepared cipher context
+ * @param options the run time options, threads is the number of workers,
+ * 0 for one worker per online CPU
+ * @return true if all files were transformed, else false
+ */
+bool BatchInput(const char *source_path, const char *output_dir,
+                const CipherContext *context, const CipherOptions *options) {
+    BatchList list = {NULL, 0, 0};
+    BatchPool pool;
+    bool is_listed = false;
+    DIR *source_dir = opendir(source_path);
+    if (source_dir != NULL) {
+        is_listed = ReadBatchDirectory(source_dir, source_path, output_dir,
+                                       &list);
+        closedir(source_dir);
+    } else {
+        FILE *manifest = fopen(source_path, "r");
+        if (manifest != NULL) {
+            is_listed = ReadBatchManifest(manifest, output_dir, &list);
+            fclose(manifest);
+        } else {
+            fprintf(stderr, ERROR_BATCH_SOURCE);
+        }
+    }
+    if (is_listed == false) {
+        FreeBatchList(&list);
+        return false;
+    }
+    size_t num_workers = options->threads;
+    if (num_workers == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = online > 0 ? (size_t) online : 1;
+    }
+    if (num_workers > list.len) {
+        num_workers = list.len;
+    }
+    pool.list = &list;
+    pool.next_job = 0;
+    pool.context = context;
+    pool.options = options;
+    pool.is_valid = true;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_t *workers = (pthread_t *) calloc(num_workers + 1,
+                                              sizeof(pthread_t));
+    size_t num_started = 0;
+    while (workers != NULL && num_started < num_workers &&
+           pthread_create(&workers[num_started], NULL, BatchWorker,
+                          &pool) == 0) {
+        num_started++;
+    }
+    if (num_started == 0) {
+        //no worker thread could start, run the batch here
+        BatchWorker(&pool);
+    }
+    for (size_t i = 0; i < num_started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    pthread_mutex_destroy(&pool.lock);
+    free(workers);
+    FreeBatchList(&list);
+    return pool.is_valid;
+}
+
+/**
+ * @brief reads the checkpoint of a followed file
+ * @param path path of the checkpoint file
+ * @param offset out parameter to hold the number of input bytes done, 0
+ * when there is no checkpoint yet
+ * @param key_pos out parameter to hold the vigenere key position at offset
+ * @return true on success, false if the checkpoint is invalid
+ */
+bool ReadCheckpoint(const char *path, unsigned long long *offset,
+                    size_t *key_pos) {
+    *offset = 0;
+    *key_pos = 0;
+    FILE *checkpoint = fopen(path, "r");
+    if (checkpoint == NULL) {
+        return errno == ENOENT;
+    }
+    bool is_valid = fscanf(checkpoint, CHECKPOINT_FORMAT, offset, key_pos) ==
+            CHECKPOINT_NUM;
+    fclose(checkpoint);
+    return is_valid;
+}
+
+/**
+ * @brief replaces the checkpoint of a followed file - writes a temporary file
+ * and renames it over the checkpoint, so a crash leaves the old or the new
+ * checkpoint and never a partial one
+ * @param path path of the checkpoint file
+ * @param offset the number of input bytes done
+ * @param key_pos the vigenere key position at offset
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool WriteCheckpoint(const char *path, unsigned long long offset,
+                     size_t key_pos) {
+    char *temp_path = (char *) malloc(strlen(path) +
+            strlen(CHECKPOINT_TEMP_SUFFIX) + 1);
+    if (temp_path == NULL) {
+        return false;
+    }
+    strcpy(temp_path, path);
+    strcat(temp_path, CHECKPOINT_TEMP_SUFFIX);
+    FILE *checkpoint = fopen(temp_path, "w");
+    bool is_valid = checkpoint != NULL &&
+            fprintf(checkpoint, CHECKPOINT_FORMAT, offset, key_pos) > 0;
+    if (checkpoint != NULL && fclose(checkpoint) != 0) {
+        is_valid = false;
+    }
+    is_valid = is_valid && rename(temp_path, path) == 0;
+    free(temp_path);
+    return is_valid;
+}
+
+/**
+ * @brief transforms the bytes appended to the input since offset, and writes
+ * them to the output at the same offset. An input that shrank was truncated
+ * or replaced, it is transformed again from its start.
+ * @param input_fd the followed input
+ * @param output_fd the output
+ * @param context the cipher context, its key position is at offset
+ * @param block buffer of block_size bytes
+ * @param block_size number of bytes read and written at once
+ * @param offset the number of input bytes done, updated
+ * @return true on success, false if an I/O error occurred
+ */
+bool FollowNewBytes(int input_fd, int output_fd, CipherContext *context,
+                    unsigned char *block, size_t block_size,
+                    unsigned long long *offset) {
+    struct stat input_stat;
+    if (fstat(input_fd, &input_stat) != 0) {
+        return false;
+    }
+    unsigned long long end = (unsigned long long) input_stat.st_size;
+    if (end < *offset) {
+        *offset = 0;
+        context->key_pos = 0;
+        if (ftruncate(output_fd, 0) != 0) {
+            return false;
+        }
+    }
+    while (*offset < end) {
+        size_t want = end - *offset < block_size ?
+                (size_t) (end - *offset) : block_size;
+        ssize_t read_len = ReadFull(input_fd, block, want, (off_t) *offset);
+        if (read_len < 0) {
+            return false;
+        }
+        if (read_len == 0) {
+            //the input was truncated meanwhile, the next round starts over
+            break;
+        }
+        CipherUpdate(context, block, block, (size_t) read_len);
+        if (WriteFull(output_fd, block, (size_t) read_len,
+                      (off_t) *offset) == false) {
+            return false;
+        }
+        *offset += (unsigned long long) read_len;
+    }
+    return true;
+}
+
+/**
+ * @brief waits until the followed input is written to again
+ * @param watch_fd the inotify instance watching the input, -1 to poll
+ * every FOLLOW_POLL_SECONDS
+ * @return true when the input may have grown, false when it was moved or
+ * deleted or the wait failed
+ */
+bool WaitForInput(int watch_fd) {
+#ifdef HAS_INOTIFY
+    if (watch_fd < 0) {
+        sleep(FOLLOW_POLL_SECONDS);
+        return true;
+    }
+    //events are read whole, aligned as struct inotify_event
+    char events[FOLLOW_EVENTS_LEN]
+            __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+    while ((len = read(watch_fd, events, sizeof(events))) < 0 &&
+           errno == EINTR) {
+    }
+    if (len <= 0) {
+        return false;
+    }
+    for (char *next = events; next < events + len;) {
+        const struct inotify_event *event = (const struct inotify_event *) next;
+        if (event->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED)) {
+            return false;
+        }
+        next += sizeof(struct inotify_event) + event->len;
+    }
+    return true;
+#else
+    (void) watch_fd;
+    sleep(FOLLOW_POLL_SECONDS);
+    return true;
+#endif
+}
+
+/**
+ * @brief follow engine - transforms only the bytes appended to the input
+ * since the last run, and writes them to the output at the same offsets.
+ * The number of input bytes done and the vigenere key position are kept in
+ * the checkpoint file next to the output, and saved once the output is on
+ * disk. Output bytes past the checkpoint, from a run that was cut short, are
+ * dropped and transformed again. With use_watch the input is followed until
+ * it is moved or deleted, woken by inotify (polled where it is missing).
+ * @param input_path path of the followed input
+ * @param output_path path of the output
+ * @param context the prepared cipher context
+ * @param options how the files are read and written
+ * @return true on success, false if the checkpoint is invalid, or an
+ * allocation or I/O error occurred
+ */
+bool FollowInput(const char *input_path, const char *output_path,
+                 CipherContext *context, const CipherOptions *options) {
+    unsigned long long offset;
+    size_t key_pos;
+    struct stat output_stat;
+    char *checkpoint_path = (char *) malloc(strlen(output_path) +
+            strlen(CHECKPOINT_SUFFIX) + 1);
+    unsigned char *block = (unsigned char *) malloc(options->block_size);
+    if (checkpoint_path == NULL || block == NULL) {
+        free(checkpoint_path);
+        free(block);
+        fprintf(stderr, ERROR_ALLOC);
+        return false;
+    }
+    strcpy(checkpoint_path, output_path);
+    strcat(checkpoint_path, CHECKPOINT_SUFFIX);
+    if (ReadCheckpoint(checkpoint_path, &offset, &key_pos) == false ||
+        (context->use_key && key_pos >= context->key_len)) {
+        free(checkpoint_path);
+        free(block);
+        fprintf(stderr, ERROR_CHECKPOINT);
+        return false;
+    }
+    int input_fd = open(input_path, O_RDONLY);
+    int output_fd = input_fd < 0 ? -1 :
+            open(output_path, O_WRONLY | O_CREAT, FOLLOW_OUTPUT_MODE);
+    int watch_fd = -1;
+#ifdef HAS_INOTIFY
+    if (options->use_watch && output_fd >= 0) {
+        //watched before the first round, so no write can be missed
+        watch_fd = inotify_init1(IN_CLOEXEC);
+        if (watch_fd >= 0 &&
+            inotify_add_watch(watch_fd, input_path, IN_MODIFY | IN_MOVE_SELF |
+                                                    IN_DELETE_SELF) < 0) {
+            close(watch_fd);
+            watch_fd = -1;
+        }
+    }
+#endif
+    bool is_valid = output_fd >= 0 && fstat(output_fd, &output_stat) == 0;
+    if (is_valid && (unsigned long long) output_stat.st_size < offset) {
+        //the output lost bytes the checkpoint counts, start over
+        offset = 0;
+        key_pos = 0;
+    }
+    is_valid = is_valid && ftruncate(output_fd, (off_t) offset) == 0;
+    context->key_pos = key_pos;
+    unsigned long long saved_offset = offset;
+    bool is_saved = false;
+    while (is_valid) {
+        is_valid = FollowNewBytes(input_fd, output_fd, context, block,
+                                  options->block_size, &offset);
+        if (is_valid && (offset != saved_offset || is_saved == false)) {
+            is_valid = fdatasync(output_fd) == 0 &&
+                    WriteCheckpoint(checkpoint_path, offset,
+                                    context->key_pos);
+            saved_offset = offset;
+            is_saved = true;
+        }
+        if (is_valid == false || options->use_watch == false ||
+            WaitForInput(watch_fd) == false) {
+            break;
+        }
+    }
+    if (is_valid == false) {
+        fprintf(stderr, ERROR_IO);
+    }
+    if (watch_fd >= 0) {
+        close(watch_fd);
+    }
+    if (output_fd >= 0) {
+        close(output_fd);
+    }
+    if (input_fd >= 0) {
+        close(input_fd);
+    }
+    free(checkpoint_path);
+    free(block);
+    return is_valid;
+}
+
+/**
+ * @brief counts every letter of a block into a 26 bins histogram, upper and
+ * lower case together
+ * @param in the bytes to count
+ * @param len number of bytes in the block
+ * @param counts the histogram to add the letters of the block to
+ */
+void CountLetters(const unsigned char *in, size_t len,
+                  unsigned long long *counts) {
+    for (size_t i = 0; i < len; i++) {
+        if (IsLetter(in[i])) {
+            counts[(in[i] | CASE_BIT) - LOWER_CASE_MIN]++;
+        }
+    }
+}
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief counts every letter of a block into a 26 bins histogram 16 bytes at
+ * a time - every bin has 16 8 bit counters, one per byte of a vector, that
+ * are summed with psadbw before they overflow
+ * @param in the bytes to count
+ * @param len number of bytes in the block
+ * @param counts the histogram to add the letters of the block to
+ */
+__attribute__((target("sse2")))
+void CountLettersSse2(const unsigned char *in, size_t len,
+                      unsigned long long *counts) {
+    const __m128i case_bit = _mm_set1_epi8(CASE_BIT);
+    const __m128i first = _mm_set1_epi8(LOWER_CASE_MIN);
+    size_t i = 0;
+    while (i + SSE2_WIDTH <= len) {
+        __m128i bins[ENGLISH_LETTERS_NUM];
+        for (int letter = 0; letter < ENGLISH_LETTERS_NUM; letter++) {
+            bins[letter] = _mm_setzero_si128();
+        }
+        for (int vector = 0; vector < COUNT_FLUSH_VECTORS &&
+                             i + SSE2_WIDTH <= len; vector++) {
+            __m128i chars = _mm_loadu_si128((const __m128i *) (in + i));
+            __m128i index = _mm_sub_epi8(_mm_or_si128(chars, case_bit),
+                                         first);
+            for (int letter = 0; letter < ENGLISH_LETTERS_NUM; letter++) {
+                bins[letter] = _mm_sub_epi8(bins[letter], _mm_cmpeq_epi8(
+                        index, _mm_set1_epi8((char) letter)));
+            }
+            i += SSE2_WIDTH;
+        }
+        for (int letter = 0; letter < ENGLISH_LETTERS_NUM; letter++) {
+            __m128i sums = _mm_sad_epu8(bins[letter], _mm_setzero_si128());
+            counts[letter] += (unsigned long long) _mm_cvtsi128_si32(sums) +
+                    (unsigned long long) _mm_cvtsi128_si32(
+                            _mm_srli_si128(sums, 8));
+        }
+    }
+    CountLetters(in + i, len - i, counts);
+}
+
+/**
+ * @brief counts every letter of a block into a 26 bins histogram 32 bytes at
+ * a time, as CountLettersSse2
+ * @param in the bytes to count
+ * @param len number of bytes in the block
+ * @param counts the histogram to add the letters of the block to
+ */
+__attribute__((target("avx2")))
+void CountLettersAvx2(const unsigned char *in, size_t len,
+                      unsigned long long *counts) {
+    const __m256i case_bit = _mm256_set1_epi8(CASE_BIT);
+    const __m256i first = _mm256_set1_epi8(LOWER_CASE_MIN);
+    size_t i = 0;
+    while (i + AVX2_WIDTH <= len) {
+        __m256i bins[ENGLISH_LETTERS_NUM];
+        for (int letter = 0; letter < ENGLISH_LETTERS_NUM; letter++) {
+            bins[letter] = _mm256_setzero_si256();
+        }
+        for (int vector = 0; vector < COUNT_FLUSH_VECTORS &&
+                             i + AVX2_WIDTH <= len; vector++) {
+            __m256i chars = _mm256_loadu_si256((const __m256i *) (in + i));
+            __m256i index = _mm256_sub_epi8(_mm256_or_si256(chars, case_bit),
+                                            first);
+            for (int letter = 0; letter < ENGLISH_LETTERS_NUM; letter++) {
+                bins[letter] = _mm256_sub_epi8(bins[letter], _mm256_cmpeq_epi8(
+                        index, _mm256_set1_epi8((char) letter)));
+            }
+            i += AVX2_WIDTH;
+        }
+        for (int letter = 0; letter < ENGLISH_LETTERS_NUM; letter++) {
+            __m256i sums = _mm256_sad_epu8(bins[letter],
+                                           _mm256_setzero_si256());
+            counts[letter] += (unsigned long long) (
+                    _mm256_extract_epi64(sums, 0) +
+                    _mm256_extract_epi64(sums, 1) +
+                    _mm256_extract_epi64(sums, 2) +
+                    _mm256_extract_epi64(sums, 3));
+        }
+    }
+    CountLettersSse2(in + i, len - i, counts);
+}
+#endif
+
+/**
+ * @brief picks the widest letter counting kernel the running CPU supports,
+ * CountLetters is the fallback for any other CPU
+ * @return the kernel to count letters with
+ */
+CountKernel SelectCountKernel(void) {
+#ifdef HAS_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return CountLettersAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return CountLettersSse2;
+    }
+#endif
+    return CountLetters;
+}
+
+/**
+ * @brief finds the shift a text was most likely encoded with - the shift
+ * whose decoding has the smallest chi-squared distance between its letter
+ * counts and english letter frequencies
+ * @param counts the 26 bins histogram of the encoded text
+ * @return the shift number k in [0, 26), 0 if there are no letters
+ */
+int BestShift(const unsigned long long *counts) {
+    int shifts[ENGLISH_LETTERS_NUM];
+    RankShifts(counts, shifts);
+    return shifts[0];
+}
+
+/**
+ * @brief chi-squared distance between the letter counts decoded with a shift
+ * and english letter frequencies
+ * @param counts the 26 bins histogram of the encoded text
+ * @param total the number of letters in the histogram, not 0
+ * @param shift the shift to decode the counts with
+ * @return the distance, smaller is more like english
+ */
+double ShiftScore(const unsigned long long *counts, double total, int shift) {
+    const double frequencies[ENGLISH_LETTERS_NUM] = ENGLISH_FREQUENCIES;
+    double score = 0;
+    for (int letter = 0; letter < ENGLISH_LETTERS_NUM; letter++) {
+        double expected = total * frequencies[letter];
+        double diff = (double) counts[(letter + shift) % ENGLISH_LETTERS_NUM] -
+                expected;
+        score += diff * diff / expected;
+    }
+    return score;
+}
+
+/**
+ * @brief orders all shifts from the most to the least likely one a text was
+ * encoded with, by their chi-squared distance to english
+ * @param counts the 26 bins histogram of the encoded text
+ * @param shifts out parameter to hold the 26 shifts in order, by shift
+ * number when there are no letters
+ */
+void RankShifts(const unsigned long long *counts, int *shifts) {
+    double scores[ENGLISH_LETTERS_NUM];
+    double total = 0;
+    for (int letter = 0; letter < ENGLISH_LETTERS_NUM; letter++) {
+        total += (double) counts[letter];
+    }
+    for (int shift = 0; shift < ENGLISH_LETTERS_NUM; shift++) {
+        scores[shift] = total == 0 ? 0 : ShiftScore(counts, total, shift);
+        //insertion sort, equal scores keep the smaller shift first
+        int i = shift;
+        for (; i > 0 && scores[shifts[i - 1]] > scores[shift]; i--) {
+            shifts[i] = shifts[i - 1];
+        }
+        shifts[i] = shift;
+    }
+}
+
+/**
+ * @brief counts the letters of CRACK_SAMPLES samples spread evenly over a
+ * regular file, or of the whole file when it is not bigger than the samples
+ * @param input the regular input file, read with pread only
+ * @param counts the histogram to add the letters to
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool CountSampledLetters(FILE **input, unsigned long long *counts) {
+    struct stat input_stat;
+    int input_fd = fileno(*input);
+    CountKernel count_letters = SelectCountKernel();
+    if (fstat(input_fd, &input_stat) != 0) {
+        return false;
+    }
+    unsigned char *sample = (unsigned char *) malloc(CRACK_SAMPLE_LEN);
+    if (sample == NULL) {
+        return false;
+    }
+    off_t size = input_stat.st_size;
+    bool is_whole = size <= (off_t) CRACK_SAMPLES * CRACK_SAMPLE_LEN;
+    for (off_t i = 0; i < CRACK_SAMPLES; i++) {
+        off_t offset = is_whole ? i * CRACK_SAMPLE_LEN :
+                i * (size - CRACK_SAMPLE_LEN) / (CRACK_SAMPLES - 1);
+        ssize_t read_len = offset < size ?
+                pread(input_fd, sample, CRACK_SAMPLE_LEN, offset) : 0;
+        if (read_len < 0) {
+            free(sample);
+            return false;
+        }
+        count_letters(sample, (size_t) read_len, counts);
+    }
+    free(sample);
+    return true;
+}
+
+/**
+ * @brief crack engine - finds the shift the input was most likely encoded
+ * with from a sample of its letters, and decodes it with that shift into the
+ * output. A regular file is sampled over its whole length, a pipe by the
+ * first CRACK_SAMPLE_LEN bytes which are then decoded first.
+ * @param input the input file to decode
+ * @param output the output file to put the decoded text
+ * @param options the run time options, without a key
+ * @param shift out parameter to hold the shift that was found
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool CrackInput(FILE **input, FILE **output, const CipherOptions *options,
+                int *shift) {
+    unsigned long long counts[ENGLISH_LETTERS_NUM] = {0};
+    if (IsRegularFile(*input)) {
+        if (CountSampledLetters(input, counts) == false) {
+            fprintf(stderr, ERROR_IO);
+            return false;
+        }
+        *shift = BestShift(counts);
+        return DecodeInput(input, output, *shift, options);
+    }
+    //a pipe is read once, so the sampled prefix is decoded and written first
+    CipherContext context;
+    unsigned char *prefix = (unsigned char *) malloc(CRACK_SAMPLE_LEN);
+    if (prefix == NULL) {
+        fprintf(stderr, ERROR_ALLOC);
+        return false;
+    }
+    setvbuf(*input, NULL, _IONBF, 0);
+    setvbuf(*output, NULL, _IONBF, 0);
+    size_t prefix_len = fread(prefix, 1, CRACK_SAMPLE_LEN, *input);
+    SelectCountKernel()(prefix, prefix_len, counts);
+    *shift = BestShift(counts);
+    CipherInit(&context, CIPHER_DECODE, *shift, options->use_table);
+    CipherUpdate(&context, prefix, prefix, prefix_len);
+    bool is_valid = ferror(*input) == 0 &&
+            fwrite(prefix, 1, prefix_len, *output) == prefix_len &&
+            StreamBlocks(input, output, &context, prefix, CRACK_SAMPLE_LEN);
+    if (is_valid == false) {
+        fprintf(stderr, ERROR_IO);
+    }
+    free(prefix);
+    return is_valid;
+}
+
+/**
+ * @brief brute force engine - reads the input once, and decodes every block
+ * with each candidate shift into its own output file, one CipherUpdate pass
+ * per candidate
+ * @param input the input file to decode, may be a pipe
+ * @param output_prefix the candidate of shift k is put in
+ * "<output_prefix>.<k>"
+ * @param options the run time options, without a key
+ * @param top number of candidates, the most english like ones, 0 for all
+ * BRUTE_SHIFTS candidates in order of their shift
+ * @param shifts out parameter to hold the shifts of the candidates, from the
+ * most english like one, room for BRUTE_SHIFTS
+ * @param num_shifts out parameter to hold the number of candidates
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool BruteInput(FILE **input, const char *output_prefix,
+                const CipherOptions *options, size_t top, int *shifts,
+                size_t *num_shifts) {
+    unsigned long long counts[ENGLISH_LETTERS_NUM] = {0};
+    int ranked[ENGLISH_LETTERS_NUM];
+    CipherContext contexts[BRUTE_SHIFTS];
+    FILE *outputs[BRUTE_SHIFTS] = {NULL};
+    size_t path_len = strlen(output_prefix) + BRUTE_SUFFIX_LEN;
+    char *path = (char *) malloc(path_len);
+    unsigned char *block = (unsigned char *) malloc(options->block_size);
+    unsigned char *decoded = (unsigned char *) malloc(options->block_size);
+    size_t block_len = 0;
+    *num_shifts = 0;
+    if (path == NULL || block == NULL || decoded == NULL) {
+        free(path);
+        free(block);
+        free(decoded);
+        fprintf(stderr, ERROR_ALLOC);
+        return false;
+    }
+    setvbuf(*input, NULL, _IONBF, 0);
+    bool is_valid = true;
+    if (top > 0 && top < BRUTE_SHIFTS) {
+        if (IsRegularFile(*input)) {
+            is_valid = CountSampledLetters(input, counts);
+        } else {
+            //a pipe is read once, so it is scored by its first block
+            block_len = fread(block, 1, options->block_size, *input);
+            is_valid = ferror(*input) == 0;
+            SelectCountKernel()(block, block_len, counts);
+        }
+    } else {
+        top = BRUTE_SHIFTS;
+    }
+    //without counts the shifts stay in order
+    RankShifts(counts, ranked);
+    for (int i = 0; i < ENGLISH_LETTERS_NUM && *num_shifts < top; i++) {
+        //shift 0 would copy the input
+        if (ranked[i] != 0) {
+            shifts[(*num_shifts)++] = ranked[i];
+        }
+    }
+    for (size_t i = 0; is_valid && i < *num_shifts; i++) {
+        CipherInit(&contexts[i], CIPHER_DECODE, shifts[i], options->use_table);
+        snprintf(path, path_len, BRUTE_PATH_FORMAT, output_prefix, shifts[i]);
+        outputs[i] = fopen(path, "w");
+        is_valid = outputs[i] != NULL;
+        if (is_valid) {
+            setvbuf(outputs[i], NULL, _IONBF, 0);
+        }
+    }
+    while (is_valid) {
+        if (block_len == 0) {
+            block_len = fread(block, 1, options->block_size, *input);
+        }
+        if (block_len == 0) {
+            break;
+        }
+        //one pass per candidate over a block read once from the input.
+        //The later passes find the block in the cache only while it fits
+        //there together with decoded, which depends on --block-size - at
+        //the default 1 MiB they may read it from memory again
+        for (size_t i = 0; is_valid && i < *num_shifts; i++) {
+            CipherUpdate(&contexts[i], block, decoded, block_len);
+            is_valid = fwrite(decoded, 1, block_len, outputs[i]) == block_len;
+        }
+        block_len = 0;
+    }
+    if (ferror(*input)) {
+        is_valid = false;
+    }
+    for (size_t i = 0; i < *num_shifts; i++) {
+        if (outputs[i] != NULL && fclose(outputs[i]) != 0) {
+            is_valid = false;
+        }
+    }
+    if (is_valid == false) {
+        fprintf(stderr, ERROR_IO);
+    }
+    free(path);
+    free(block);
+    free(decoded);
+    return is_valid;
+}
+
+/**
+ * @brief reads the kernel's counters of the read and write system calls this
+ * process made so far, all threads together. Mapped file pages are not read
+ * or written by system calls, so they are not counted.
+ * @param counters out parameter to hold the counters
+ * @return true on success, false if the kernel does not provide them
+ */
+bool CipherReadIoCounters(CipherIoCounters *counters) {
+    FILE *io_file = fopen(IO_COUNTERS_PATH, "r");
+    if (io_file == NULL) {
+        return false;
+    }
+    bool is_valid = fscanf(io_file, IO_COUNTERS_FORMAT, &counters->read_bytes,
+                           &counters->write_bytes, &counters->read_calls,
+                           &counters->write_calls) == IO_COUNTERS_NUM;
+    fclose(io_file);
+    return is_valid;
+}
+
+/**
+ * @brief reads the numbers of blocks and bytes CipherUpdate transformed in
+ * this process so far, all threads together
+ * @param counters out parameter to hold the counters
+ */
+void CipherReadTransformCounters(CipherTransformCounters *counters) {
+    counters->blocks = __atomic_load_n(&transform_counters.blocks,
+                                       __ATOMIC_RELAXED);
+    counters->bytes = __atomic_load_n(&transform_counters.bytes,
+                                      __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief sends a reply line to a daemon client, a client that went away is
+ * ignored
+ * @param connection the client connection
+ * @param reply the reply line
+ */
+void SendReply(int connection, const char *reply) {
+    send(connection, reply, strlen(reply), MSG_NOSIGNAL);
+}
+
+/**
+ * @brief reads the monotonic clock
+ * @return the time in milliseconds since an unspecified start
+ */
+long long MonotonicMillis(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long) now.tv_sec * MILLIS_PER_SECOND +
+            now.tv_nsec / NANOS_PER_MILLI;
+}
+
+/**
+ * @brief receives a request line and the file descriptors passed with it
+ * @param connection the client connection
+ * @param request buffer of DAEMON_REQUEST_LEN bytes to hold the line, null
+ * terminated
+ * @param fds out parameter to hold up to DAEMON_FDS passed descriptors
+ * @param num_fds out parameter to hold the number of passed descriptors
+ * @return true on success, false if no complete line was received within
+ * DAEMON_REQUEST_TIMEOUT_MS
+ */
+bool ReceiveRequest(int connection, char *request, int *fds,
+                    size_t *num_fds) {
+    size_t len = 0;
+    long long deadline = MonotonicMillis() + DAEMON_REQUEST_TIMEOUT_MS;
+    *num_fds = 0;
+    while (len < DAEMON_REQUEST_LEN - 1 &&
+           memchr(request, '\n', len) == NULL) {
+        //the whole line shares one deadline, so a client sending a byte at
+        //a time cannot hold the worker either
+        long long remaining = deadline - MonotonicMillis();
+        struct pollfd ready = {connection, POLLIN, 0};
+        int num_ready = remaining > 0 ? poll(&ready, 1, (int) remaining) : 0;
+        if (num_ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (num_ready <= 0) {
+            break;
+        }
+        union {
+            struct cmsghdr header;
+            char buffer[CMSG_SPACE(DAEMON_FDS * sizeof(int))];
+        } control;
+        struct iovec data = {request + len, DAEMON_REQUEST_LEN - 1 - len};
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = &data;
+        message.msg_iovlen = 1;
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+        ssize_t received = recvmsg(connection, &message, MSG_CMSG_CLOEXEC);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        len += (size_t) received;
+        for (struct cmsghdr *header = CMSG_FIRSTHDR(&message); header != NULL;
+             header = CMSG_NXTHDR(&message, header)) {
+            if (header->cmsg_level != SOL_SOCKET ||
+                header->cmsg_type != SCM_RIGHTS) {
+                continue;
+            }
+            size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            for (size_t i = 0; i < count; i++) {
+                int fd;
+                memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(fd));
+                if (*num_fds < DAEMON_FDS) {
+                    fds[(*num_fds)++] = fd;
+                } else {
+                    close(fd);
+                }
+            }
+        }
+    }
+    request[len] = '\0';
+    return memchr(request, '\n', len) != NULL;
+}
+
+/**
+ * @brief opens the input and output of a daemon job, from the passed
+ * descriptors when the paths are DAEMON_PASSED_PATH, or one file for both
+ * when they are the same file
+ * @param input_path the input path of the request
+ * @param output_path the output path of the request
+ * @param fds the passed descriptors, taken over by the files
+ * @param num_fds number of passed descriptors
+ * @param input out parameter to hold the input, NULL if it failed to open
+ * @param output out parameter to hold the output, NULL if it failed to open
+ */
+void OpenDaemonFiles(const char *input_path, const char *output_path,
+                     int *fds, size_t num_fds, FILE **input, FILE **output) {
+    struct stat input_stat;
+    struct stat output_stat;
+    *input = NULL;
+    *output = NULL;
+    if (strcmp(input_path, DAEMON_PASSED_PATH) != 0) {
+        if (IsSameFile(input_path, output_path)) {
+            *input = fopen(input_path, "r+");
+            *output = *input;
+            return;
+        }
+        *input = fopen(input_path, "r");
+        *output = *input == NULL ? NULL : fopen(output_path, "w");
+        return;
+    }
+    if (num_fds != DAEMON_FDS || strcmp(output_path, DAEMON_PASSED_PATH) != 0) {
+        return;
+    }
+    if (fstat(fds[0], &input_stat) == 0 && fstat(fds[1], &output_stat) == 0 &&
+        S_ISREG(input_stat.st_mode) &&
+        input_stat.st_dev == output_stat.st_dev &&
+        input_stat.st_ino == output_stat.st_ino) {
+        //passed twice to transform in place
+        *input = fdopen(fds[0], "r+");
+        *output = *input;
+        if (*input != NULL) {
+            fds[0] = -1;
+        }
+        return;
+    }
+    *input = fdopen(fds[0], "r");
+    if (*input != NULL) {
+        fds[0] = -1;
+        *output = fdopen(fds[1], "w");
+    }
+    if (*output != NULL) {
+        fds[1] = -1;
+    }
+}
+
+/**
+ * @brief runs one daemon job - parses the request line, transforms the
+ * input into the output with the worker's block buffer and replies
+ * @param connection the client connection
+ * @param options the daemon options
+ * @param block the worker's buffer of options->block_size bytes
+ */
+void RunDaemonJob(int connection, const CipherOptions *options,
+                  unsigned char *block) {
+    char request[DAEMON_REQUEST_LEN];
+    char *fields[DAEMON_FIELDS] = {NULL};
+    int fds[DAEMON_FDS] = {-1, -1};
+    size_t num_fds = 0;
+    FILE *input = NULL;
+    FILE *output = NULL;
+    CipherContext context;
+    CipherOptions job_options = *options;
+    //NULL while the job goes well
+    const char *reply = DAEMON_REPLY_REQUEST;
+    if (ReceiveRequest(connection, request, fds, &num_fds)) {
+        char *text = request;
+        char *save = NULL;
+        for (size_t i = 0; i < DAEMON_FIELDS; i++) {
+            fields[i] = strtok_r(text, MANIFEST_DELIMS, &save);
+            text = NULL;
+        }
+    }
+    const char *command = fields[DAEMON_FIELD_COMMAND];
+    const char *flags = fields[DAEMON_FIELD_FLAGS];
+    if (fields[DAEMON_FIELD_OUTPUT] != NULL &&
+        (strcmp(command, DAEMON_ENCODE) == 0 ||
+         strcmp(command, DAEMON_DECODE) == 0) &&
+        strspn(flags, DAEMON_FLAGS) == strlen(flags)) {
+        CipherMode mode = strcmp(command, DAEMON_ENCODE) == 0 ?
+                CIPHER_ENCODE : CIPHER_DECODE;
+        job_options.use_table = strchr(flags, DAEMON_FLAG_TABLE) != NULL;
+        job_options.key = strchr(flags, DAEMON_FLAG_KEY) != NULL ?
+                fields[DAEMON_FIELD_SHIFT] : NULL;
+        reply = NULL;
+        if (job_options.key != NULL) {
+            if (CipherInitKey(&context, mode, job_options.key) == false) {
+                reply = DAEMON_REPLY_SHIFT;
+            }
+        } else if (atoi(fields[DAEMON_FIELD_SHIFT]) < 0) {
+            reply = DAEMON_REPLY_SHIFT;
+        } else {
+            CipherInit(&context, mode, atoi(fields[DAEMON_FIELD_SHIFT]),
+                       job_options.use_table);
+        }
+    }
+    if (reply == NULL) {
+        OpenDaemonFiles(fields[DAEMON_FIELD_INPUT],
+                        fields[DAEMON_FIELD_OUTPUT], fds, num_fds, &input,
+                        &output);
+        reply = output == NULL ? DAEMON_REPLY_FILE : NULL;
+    }
+    if (reply == NULL && input == output) {
+        job_options.threads = 1;
+        reply = ProcessInput(&input, &output, &context, &job_options) ?
+                NULL : DAEMON_REPLY_IO;
+    } else if (reply == NULL) {
+        setvbuf(input, NULL, _IONBF, 0);
+        setvbuf(output, NULL, _IONBF, 0);
+        reply = StreamBlocks(&input, &output, &context, block,
+                             options->block_size) ? NULL : DAEMON_REPLY_IO;
+    }
+    if (output != NULL && output != input && fclose(output) != 0) {
+        reply = DAEMON_REPLY_IO;
+    }
+    if (input != NULL) {
+        fclose(input);
+    }
+    for (size_t i = 0; i < num_fds; i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+    SendReply(connection, reply == NULL ? DAEMON_REPLY_OK : reply);
+}
+
+/**
+ * @brief daemon worker thread - keeps one block buffer, touched up front so
+ * no job waits for its pages, and runs the next pending connection until
+ * the daemon stops
+ * @param arg the DaemonPool shared by all workers
+ * @return NULL
+ */
+void *DaemonWorker(void *arg) {
+    DaemonPool *pool = (DaemonPool *) arg;
+    unsigned char *block = (unsigned char *) malloc(
+            pool->options->block_size);
+    if (block != NULL) {
+        memset(block, 0, pool->options->block_size);
+    }
+    while (true) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->len == 0 && pool->is_stopping == false) {
+            pthread_cond_wait(&pool->has_job, &pool->lock);
+        }
+        if (pool->len == 0) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        int connection = pool->pending[pool->head];
+        pool->head = (pool->head + 1) % DAEMON_QUEUE_LEN;
+        pool->len--;
+        pthread_cond_signal(&pool->has_room);
+        pthread_mutex_unlock(&pool->lock);
+        if (block == NULL) {
+            SendReply(connection, DAEMON_REPLY_ALLOC);
+        } else {
+            RunDaemonJob(connection, pool->options, block);
+        }
+        close(connection);
+    }
+    free(block);
+    return NULL;
+}
+
+/**
+ * @brief fills the address of a unix domain socket
+ * @param address the address to fill
+ * @param socket_path path of the socket
+ * @return true on success, false if the path is too long
+ */
+bool FillSocketAddress(struct sockaddr_un *address, const char *socket_path) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address->sun_path)) {
+        return false;
+    }
+    strcpy(address->sun_path, socket_path);
+    return true;
+}
+
+/**
+ * @brief binds and listens on a unix domain socket only this user can
+ * connect to. A socket file left by a daemon that is gone is replaced.
+ * @param socket_path path of the socket
+ * @return the listening socket, -1 on error
+ */
+int ListenDaemonSocket(const char *socket_path) {
+    struct sockaddr_un address;
+    struct stat socket_stat;
+    if (FillSocketAddress(&address, socket_path) == false) {
+        return -1;
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        return -1;
+    }
+    if (stat(socket_path, &socket_stat) == 0 && S_ISSOCK(socket_stat.st_mode) &&
+        connect(listener, (const struct sockaddr *) &address,
+                sizeof(address)) != 0 && errno == ECONNREFUSED) {
+        unlink(socket_path);
+    }
+    close(listener);
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    mode_t old_mask = umask(DAEMON_SOCKET_MASK);
+    bool is_valid = listener >= 0 &&
+            bind(listener, (const struct sockaddr *) &address,
+                 sizeof(address)) == 0;
+    umask(old_mask);
+    if (is_valid == false || listen(listener, DAEMON_QUEUE_LEN) != 0) {
+        if (listener >= 0) {
+            close(listener);
+        }
+        return -1;
+    }
+    return listener;
+}
+
+/**
+ * @brief daemon engine - listens on a unix domain socket and runs every
+ * connection as a job on a warm pool of worker threads, until is_stopped is
+ * set. A signal that sets it must interrupt accept, so its handler must not
+ * be installed with SA_RESTART.
+ * @param socket_path path of the socket
+ * @param options the daemon options, threads is the number of workers, 0
+ * for one worker per online CPU
+ * @param is_stopped set to stop the daemon
+ * @return true when stopped, false if the socket could not be set up
+ */
+bool CipherServe(const char *socket_path, const CipherOptions *options,
+                 const volatile sig_atomic_t *is_stopped) {
+    DaemonPool pool;
+    int listener = ListenDaemonSocket(socket_path);
+    if (listener < 0) {
+        fprintf(stderr, ERROR_DAEMON_SOCKET);
+        return false;
+    }
+    size_t num_workers = options->threads;
+    if (num_workers == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = online > 0 ? (size_t) online : 1;
+    }
+    pool.head = 0;
+    pool.len = 0;
+    pool.is_stopping = false;
+    pool.options = options;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.has_job, NULL);
+    pthread_cond_init(&pool.has_room, NULL);
+    pthread_t *workers = (pthread_t *) calloc(num_workers, sizeof(pthread_t));
+    size_t num_started = 0;
+    while (workers != NULL && num_started < num_workers &&
+           pthread_create(&workers[num_started], NULL, DaemonWorker,
+                          &pool) == 0) {
+        num_started++;
+    }
+    bool is_valid = num_started > 0;
+    if (is_valid == false) {
+        fprintf(stderr, ERROR_ALLOC);
+    }
+    while (is_valid && *is_stopped == 0) {
+        int connection = accept(listener, NULL, NULL);
+        if (connection < 0) {
+            continue;
+        }
+        pthread_mutex_lock(&pool.lock);
+        while (pool.len == DAEMON_QUEUE_LEN) {
+            pthread_cond_wait(&pool.has_room, &pool.lock);
+        }
+        pool.pending[(pool.head + pool.len) % DAEMON_QUEUE_LEN] = connection;
+        pool.len++;
+        pthread_cond_signal(&pool.has_job);
+        pthread_mutex_unlock(&pool.lock);
+    }
+    //the pending jobs are still run before the workers stop
+    pthread_mutex_lock(&pool.lock);
+    pool.is_stopping = true;
+    pthread_cond_broadcast(&pool.has_job);
+    pthread_mutex_unlock(&pool.lock);
+    for (size_t i = 0; i < num_started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    close(listener);
+    unlink(socket_path);
+    pthread_cond_destroy(&pool.has_room);
+    pthread_cond_destroy(&pool.has_job);
+    pthread_mutex_destroy(&pool.lock);
+    free(workers);
+    return is_valid;
+}
+
+/**
+ * @brief sends a job to a running daemon and waits for its reply
+ * @param socket_path path of the daemon's socket
+ * @param request the request line, ending with a new line
+ * @param input_fd the input to pass, -1 to pass no descriptors
+ * @param output_fd the output to pass, may be input_fd to transform in place
+ * @return true if the daemon ran the job, false if it failed or the daemon
+ * could not be reached
+ */
+bool CipherSubmit(const char *socket_path, const char *request, int input_fd,
+                  int output_fd) {
+    struct sockaddr_un address;
+    char reply[DAEMON_REQUEST_LEN];
+    size_t reply_len = 0;
+    int connection = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connection < 0 || FillSocketAddress(&address, socket_path) == false ||
+        connect(connection, (const struct sockaddr *) &address,
+                sizeof(address)) != 0) {
+        if (connection >= 0) {
+            close(connection);
+        }
+        fprintf(stderr, ERROR_DAEMON_SOCKET);
+        return false;
+    }
+    union {
+        struct cmsghdr header;
+        char buffer[CMSG_SPACE(DAEMON_FDS * sizeof(int))];
+    } control;
+    int fds[DAEMON_FDS] = {input_fd, output_fd};
+    struct iovec data = {(void *) request, strlen(request)};
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    memset(&control, 0, sizeof(control));
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    if (input_fd >= 0) {
+        message.msg_control = control.buffer;
+        message.msg_controllen = sizeof(control.buffer);
+        struct cmsghdr *header = CMSG_FIRSTHDR(&message);
+        header->cmsg_level = SOL_SOCKET;
+        header->cmsg_type = SCM_RIGHTS;
+        header->cmsg_len = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(header), fds, sizeof(fds));
+    }
+    bool is_valid = sendmsg(connection, &message, MSG_NOSIGNAL) ==
+            (ssize_t) data.iov_len;
+    while (is_valid && reply_len < sizeof(reply) - 1) {
+        ssize_t received = recv(connection, reply + reply_len,
+                                sizeof(reply) - 1 - reply_len, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        reply_len += (size_t) received;
+    }
+    close(connection);
+    reply[reply_len] = '\0';
+    if (is_valid == false || reply_len == 0) {
+        fprintf(stderr, ERROR_DAEMON_SOCKET);
+        return false;
+    }
+    if (strcmp(reply, DAEMON_REPLY_OK) != 0) {
+        fprintf(stderr, "%s", reply);
+        return false;
+    }
+    return true;
+}
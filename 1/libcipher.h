@@ -0,0 +1,690 @@
+/**
+ * libcipher - the cipher algorithm as a library, encodes and decodes memory
+ * buffers and files inside the calling process
+ */
+
+#ifndef CIPHER_LIBCIPHER_H_
+#define CIPHER_LIBCIPHER_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <signal.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/**
+ * @brief the vectorized x86 kernels can be compiled
+ */
+#define HAS_X86_KERNELS
+#endif
+
+/**
+ * @brief number of english letter in the alphabet
+ */
+#define ENGLISH_LETTERS_NUM 26
+/**
+ * @brief number of candidate decodings of a brute force run, every shift but
+ * 0
+ */
+#define BRUTE_SHIFTS (ENGLISH_LETTERS_NUM - 1)
+/**
+ * @brief number of entries in a translation table - one for every byte value
+ */
+#define TABLE_SIZE 256
+/**
+ * @brief default size of a read/write block - 1 MiB
+ */
+#define DEFAULT_BLOCK_SIZE (1024 * 1024)
+/**
+ * @brief default number of input bytes in a frame of a framed file - 64 KiB
+ */
+#define DEFAULT_FRAME_SIZE (64 * 1024)
+/**
+ * @brief max number of letters in a vigenere key word
+ */
+#define MAX_KEY_LEN 256
+/**
+ * @brief the key stream repeats the key over MAX_KEY_LEN + KEY_STREAM_PAD
+ * shifts, so a vector of 32 shifts can be loaded from any position up to a
+ * whole number of key lengths of at least 32
+ */
+#define KEY_STREAM_PAD 32
+
+/**
+ * @brief a function that encodes a block with a shift number, in may be
+ * equal to out to encode in place
+ */
+typedef void (*ShiftKernel)(const unsigned char *in, unsigned char *out,
+                            size_t len, int shift_k);
+
+/**
+ * @brief a function that maps every byte of a block through a translation
+ * table of TABLE_SIZE entries, in may be equal to out to map in place
+ */
+typedef void (*TableKernel)(const unsigned char *in, unsigned char *out,
+                            size_t len, const unsigned char *table);
+
+/**
+ * @brief a function that encodes a block with a vigenere key stream, in may
+ * be equal to out to encode in place. key_pos is the position in the key of
+ * the next letter and is updated.
+ */
+typedef void (*KeyKernel)(const unsigned char *in, unsigned char *out,
+                          size_t len, const unsigned char *key_stream,
+                          size_t key_len, size_t *key_pos);
+
+/**
+ * @brief a function that adds the letters of a block to a 26 bins
+ * histogram, upper and lower case together
+ */
+typedef void (*CountKernel)(const unsigned char *in, size_t len,
+                            unsigned long long *counts);
+
+/**
+ * @brief a function that adds a block to a CRC32C checksum, 0 starts a
+ * checksum
+ */
+typedef unsigned (*CrcKernel)(unsigned crc, const unsigned char *in,
+                              size_t len);
+
+/**
+ * @brief a function that finds the length of the run of ascii bytes a block
+ * starts with
+ */
+typedef size_t (*AsciiKernel)(const unsigned char *in, size_t len);
+
+/**
+ * @brief the validation of a UTF-8 text, carried from one block to the
+ * next. pending is the number of continuation bytes still expected, the
+ * next one in [low, high], of the sequence at sequence_start. offset is the
+ * number of bytes validated, the offset of the first invalid byte once
+ * is_valid is false.
+ */
+typedef struct Utf8State {
+    bool is_valid;
+    int pending;
+    unsigned char low;
+    unsigned char high;
+    unsigned long long sequence_start;
+    unsigned long long offset;
+} Utf8State;
+
+/**
+ * @brief whether a cipher context encodes or decodes
+ */
+typedef enum CipherMode {
+    CIPHER_ENCODE,
+    CIPHER_DECODE
+} CipherMode;
+
+/**
+ * @brief how the bytes of every buffer are transformed - shifted by a shift
+ * kernel, mapped by a translation table built once when use_table is set, or
+ * shifted by a vigenere key stream when use_key is set. The key position
+ * carries on from one buffer to the next, and so do the CRC32C checksums of
+ * all input and output bytes when use_crc is set, and the UTF-8 validation
+ * of the input when use_utf8 is set.
+ */
+typedef struct CipherContext {
+    int shift_k;
+    ShiftKernel shift_kernel;
+    bool use_table;
+    unsigned char table[TABLE_SIZE];
+    TableKernel table_kernel;
+    bool use_key;
+    unsigned char key_stream[MAX_KEY_LEN + KEY_STREAM_PAD];
+    size_t key_len;
+    size_t key_pos;
+    KeyKernel key_kernel;
+    bool use_crc;
+    CrcKernel crc_kernel;
+    unsigned input_crc;
+    unsigned output_crc;
+    bool use_utf8;
+    AsciiKernel ascii_kernel;
+    Utf8State utf8;
+} CipherContext;
+
+/**
+ * @brief how files are read, transformed and written. threads is the number
+ * of worker threads, 0 when not set - one for a single file, one per online
+ * CPU for a batch. key is a vigenere key word, NULL to shift by k.
+ * use_uring pipelines the blocks of a regular file through io_uring, where
+ * the kernel has it, else blocks are read and written with pread/pwrite.
+ * use_frames encodes into, and decodes from, frames of frame_size input bytes
+ * - only the range_len bytes from range_start of the decoded file are
+ * decoded when use_range is set. use_watch keeps following a file until it
+ * is moved or deleted. use_crc checksums the input and the output in the
+ * same pass as the transform. use_utf8 fails unless the input is valid
+ * UTF-8.
+ */
+typedef struct CipherOptions {
+    size_t block_size;
+    bool use_table;
+    bool use_mmap;
+    bool use_uring;
+    bool use_frames;
+    size_t frame_size;
+    bool use_range;
+    unsigned long long range_start;
+    unsigned long long range_len;
+    bool use_watch;
+    bool use_crc;
+    bool use_utf8;
+    size_t threads;
+    const char *key;
+} CipherOptions;
+
+/**
+ * @brief numbers of read and write system calls made by a process, and of
+ * the bytes they moved
+ */
+typedef struct CipherIoCounters {
+    unsigned long long read_calls;
+    unsigned long long write_calls;
+    unsigned long long read_bytes;
+    unsigned long long write_bytes;
+} CipherIoCounters;
+
+/**
+ * @brief numbers of blocks transformed by CipherUpdate in a process, and of
+ * the bytes in them
+ */
+typedef struct CipherTransformCounters {
+    unsigned long long blocks;
+    unsigned long long bytes;
+} CipherTransformCounters;
+
+/**
+ * @brief enocdes one char with the given shift number k
+ * @param character the character to encode
+ * @param shift_k the shifting number to encode with
+ * @return the new enocded character in DEC
+ */
+int EncodeChar(int character, int shift_k);
+
+/**
+ * @brief decoding one char with the given shift k number
+ * @param character the character to decode
+ * @param shift_k the shift number to decode
+ * @return the decoded character in DEC
+ */
+int DecodeChar(int character, int shift_k);
+
+/**
+ * @brief checks whether a character is an english letter of any case
+ * @param character the character to check
+ * @return true if it is a letter, else false
+ */
+bool IsLetter(int character);
+
+/**
+ * @brief encodes a whole block with the given shift number k, one
+ * EncodeChar per byte
+ * @param in the bytes to encode
+ * @param out where to put the encoded bytes
+ * @param len number of bytes in the block
+ * @param shift_k the shifting number to encode with
+ */
+void EncodeBlock(const unsigned char *in, unsigned char *out,
+                 size_t len, int shift_k);
+
+/**
+ * @brief fills a translation table that encodes every byte value with the
+ * given shift number k
+ * @param table the table of TABLE_SIZE entries to fill
+ * @param shift_k the shifting number to encode with
+ */
+void BuildShiftTable(unsigned char *table, int shift_k);
+
+/**
+ * @brief maps every byte of a block through a translation table
+ * @param in the bytes to map
+ * @param out where to put the mapped bytes
+ * @param len number of bytes in the block
+ * @param table the translation table of TABLE_SIZE entries
+ */
+void TranslateBlock(const unsigned char *in, unsigned char *out,
+                    size_t len, const unsigned char *table);
+
+/**
+ * @brief encodes a block with a vigenere key stream - every letter is shifted
+ * by the next shift of the key stream, other bytes are kept and do not use
+ * a shift
+ * @param in the bytes to encode
+ * @param out where to put the encoded bytes
+ * @param len number of bytes in the block
+ * @param key_stream the shifts of the key, repeated
+ * @param key_len number of letters in the key
+ * @param key_pos position in the key of the next letter, updated
+ */
+void EncodeBlockKey(const unsigned char *in, unsigned char *out, size_t len,
+                    const unsigned char *key_stream, size_t key_len,
+                    size_t *key_pos);
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief EncodeBlock 16/32/64 bytes at a time, the caller must check the
+ * CPU supports SSE2/AVX2/AVX-512BW
+ */
+void EncodeBlockSse2(const unsigned char *in, unsigned char *out,
+                     size_t len, int shift_k);
+void EncodeBlockAvx2(const unsigned char *in, unsigned char *out,
+                     size_t len, int shift_k);
+void EncodeBlockAvx512(const unsigned char *in, unsigned char *out,
+                       size_t len, int shift_k);
+
+/**
+ * @brief TranslateBlock 16/32 bytes at a time, the caller must check the
+ * CPU supports SSSE3/AVX2
+ */
+void TranslateBlockSsse3(const unsigned char *in, unsigned char *out,
+                         size_t len, const unsigned char *table);
+void TranslateBlockAvx2(const unsigned char *in, unsigned char *out,
+                        size_t len, const unsigned char *table);
+
+/**
+ * @brief EncodeBlockKey 16/32 bytes at a time, the caller must check the CPU
+ * supports SSSE3/AVX2 and POPCNT
+ */
+void EncodeBlockKeySsse3(const unsigned char *in, unsigned char *out,
+                         size_t len, const unsigned char *key_stream,
+                         size_t key_len, size_t *key_pos);
+void EncodeBlockKeyAvx2(const unsigned char *in, unsigned char *out,
+                        size_t len, const unsigned char *key_stream,
+                        size_t key_len, size_t *key_pos);
+#endif
+
+/**
+ * @brief picks the widest encoding kernel the running CPU supports
+ * @return the kernel to encode blocks with
+ */
+ShiftKernel SelectShiftKernel(void);
+
+/**
+ * @brief picks the widest table kernel the running CPU supports
+ * @return the kernel to map blocks with
+ */
+TableKernel SelectTableKernel(void);
+
+/**
+ * @brief picks the widest vigenere kernel the running CPU supports
+ * @return the kernel to encode blocks with a key stream
+ */
+KeyKernel SelectKeyKernel(void);
+
+/**
+ * @brief prepares a cipher context that encodes or decodes with the given
+ * shift number k
+ * @param context the context to prepare
+ * @param mode whether the context encodes or decodes
+ * @param k the shifting number to encode or decode with, k >= 0
+ * @param use_table true to map the bytes through a translation table
+ */
+void CipherInit(CipherContext *context, CipherMode mode, int k,
+                bool use_table);
+
+/**
+ * @brief prepares a vigenere cipher context - the i-th letter of the text is
+ * shifted by the alphabet index of the (i mod key length)-th letter of the
+ * key word, so "b" is the same as k = 1. Other bytes are kept and do not
+ * take a letter of the key.
+ * @param context the context to prepare
+ * @param mode whether the context encodes or decodes
+ * @param key the key word, letters of any case
+ * @return true on success, false if the key is empty, longer than
+ * MAX_KEY_LEN or has other bytes than letters
+ */
+bool CipherInitKey(CipherContext *context, CipherMode mode, const char *key);
+
+/**
+ * @brief prepares a cipher context from the options - with the vigenere key
+ * when one is given, else with the shift number k. Errors are printed to
+ * stderr.
+ * @param context the context to prepare
+ * @param mode whether the context encodes or decodes
+ * @param k the shifting number, used without a key
+ * @param options the options holding the key and the table mode
+ * @return true on success, false if the key is invalid
+ */
+bool CipherPrepare(CipherContext *context, CipherMode mode, int k,
+                   const CipherOptions *options);
+
+/**
+ * @brief transforms a buffer with a prepared context, in may be equal to out
+ * to transform it in place. Buffers of a stream may be given one after
+ * another in any sizes. With use_crc the checksums of the input and the
+ * output, and with use_utf8 the validation of the input, are updated in the
+ * same pass.
+ * @param context the prepared cipher context
+ * @param in the bytes to transform
+ * @param out where to put the transformed bytes
+ * @param len number of bytes in the buffer
+ */
+void CipherUpdate(CipherContext *context, const unsigned char *in,
+                  unsigned char *out, size_t len);
+
+/**
+ * @brief fills options for a streaming run with blocks of DEFAULT_BLOCK_SIZE
+ * and the default number of threads
+ * @param options the options to fill
+ */
+void CipherDefaultOptions(CipherOptions *options);
+
+/**
+ * @brief checks whether an open file is a regular file
+ * @param file the file to check
+ * @return true if the file is a regular file, else false
+ */
+bool IsRegularFile(FILE *file);
+
+/**
+ * @brief checks whether two paths name the same regular file
+ * @param first_path the first path to check
+ * @param second_path the second path to check
+ * @return true if both are the same regular file, else false
+ */
+bool IsSameFile(const char *first_path, const char *second_path);
+
+/**
+ * @brief transforms the input file into the output file with a prepared
+ * context and the engine the options select. Errors are printed to stderr.
+ * @param input the input file
+ * @param output the output file, the input itself to transform in place
+ * @param context the prepared cipher context
+ * @param options how the files are read and written
+ * @return true on success, false if the input is not valid UTF-8 with
+ * use_utf8, or an allocation or I/O error occurred
+ */
+bool ProcessInput(FILE **input, FILE **output, CipherContext *context,
+                  const CipherOptions *options);
+
+/**
+ * @brief batch engine - transforms many files on a fixed pool of worker
+ * threads, every worker reuses one block buffer for all its files.
+ * Errors are printed to stderr and the other files are still transformed.
+ * @param source_path a directory whose regular files are transformed into
+ * output_dir under the same names, or a manifest file whose lines hold an
+ * input path and an output path separated by white space (relative output
+ * paths are put under output_dir)
+ * @param output_dir the directory to put the outputs in
+ * @param context the prepared cipher context, every file starts from a copy
+ * @param options how the files are read and written, threads is the number
+ * of workers, 0 for one worker per online CPU
+ * @return true if all files were transformed, else false
+ */
+bool BatchInput(const char *source_path, const char *output_dir,
+                const CipherContext *context, const CipherOptions *options);
+
+/**
+ * @brief adds a buffer to a CRC32C (Castagnoli) checksum
+ * @param crc the checksum of the bytes before the buffer, 0 to start
+ * @param in the bytes to add
+ * @param len number of bytes in the buffer
+ * @return the checksum including the buffer
+ */
+unsigned Crc32c(unsigned crc, const unsigned char *in, size_t len);
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief Crc32c with the crc32 instruction, the caller must check the CPU
+ * supports SSE4.2
+ */
+unsigned Crc32cSse42(unsigned crc, const unsigned char *in, size_t len);
+#endif
+
+/**
+ * @brief picks the crc32 instruction when the running CPU has it, Crc32c is
+ * the fallback for any other CPU
+ * @return the kernel to checksum blocks with
+ */
+CrcKernel SelectCrcKernel(void);
+
+/**
+ * @brief combines the checksums of two consecutive buffers into the
+ * checksum of both, without their bytes
+ * @param first_crc the checksum of the first buffer
+ * @param second_crc the checksum of the second buffer
+ * @param second_len number of bytes in the second buffer
+ * @return the checksum of the first buffer followed by the second
+ */
+unsigned Crc32cCombine(unsigned first_crc, unsigned second_crc,
+                       unsigned long long second_len);
+
+/**
+ * @brief framed encoding engine - encodes the input into a framed file: a
+ * header of a magic and the frame size, then frames of frame_size input
+ * bytes (the last one fewer), each behind a header of its input offset,
+ * length, vigenere key position and the CRC32C of its encoded bytes.
+ * Errors are printed to stderr.
+ * @param input the input file to encode, may be a pipe
+ * @param output the output file to put the frames, may be a pipe
+ * @param context the prepared cipher context
+ * @param options how the files are read and written, the frame size
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool FrameEncodeInput(FILE **input, FILE **output, CipherContext *context,
+                      const CipherOptions *options);
+
+/**
+ * @brief framed decoding engine - decodes a framed file, or only a range of
+ * it reading just the frames that hold the range. With more than one thread
+ * and a regular output, runs of frames are decoded by worker threads at
+ * once. Errors are printed to stderr.
+ * @param input the regular framed file to decode
+ * @param output the output file to put the decoded range
+ * @param context the prepared cipher context
+ * @param options how the files are read and written, the range and threads
+ * @return true on success, false if the frames are invalid or corrupted, or
+ * an allocation or I/O error occurred
+ */
+bool FrameDecodeInput(FILE **input, FILE **output, CipherContext *context,
+                      const CipherOptions *options);
+
+/**
+ * @brief enocoding main function - goes over the input file and encodes it
+ * @param input the input file to encode
+ * @param output the file to put the encoded text
+ * @param k the shift number for encoding
+ * @param options how the files are read and written
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool EncodeInput(FILE **input, FILE **output, int k,
+                 const CipherOptions *options);
+
+/**
+ * @brief main decoding function, gets input file and decodes it into output
+ * file
+ * @param input the input file to decode
+ * @param output the file to put the decoded text
+ * @param k the shift number for decoding
+ * @param options how the files are read and written
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool DecodeInput(FILE **input, FILE **output, int k,
+                 const CipherOptions *options);
+
+/**
+ * @brief follow engine - transforms only the bytes appended to the input
+ * since the last run, and writes them to the output at the same offsets. The
+ * number of input bytes done and the vigenere key position are kept in a
+ * checkpoint file next to the output, under the output path and the suffix
+ * ".checkpoint". An input that shrank was truncated or replaced and is
+ * transformed again from its start. With use_watch the input is followed
+ * until it is moved or deleted. Errors are printed to stderr.
+ * @param input_path path of the followed input
+ * @param output_path path of the output, not the input itself
+ * @param context the prepared cipher context
+ * @param options how the files are read and written, use_watch
+ * @return true on success, false if the checkpoint is invalid, or an
+ * allocation or I/O error occurred
+ */
+bool FollowInput(const char *input_path, const char *output_path,
+                 CipherContext *context, const CipherOptions *options);
+
+/**
+ * @brief counts every letter of a block into a 26 bins histogram, upper and
+ * lower case together
+ * @param in the bytes to count
+ * @param len number of bytes in the block
+ * @param counts the histogram to add the letters of the block to
+ */
+void CountLetters(const unsigned char *in, size_t len,
+                  unsigned long long *counts);
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief CountLetters 16/32 bytes at a time, the caller must check the CPU
+ * supports SSE2/AVX2
+ */
+void CountLettersSse2(const unsigned char *in, size_t len,
+                      unsigned long long *counts);
+void CountLettersAvx2(const unsigned char *in, size_t len,
+                      unsigned long long *counts);
+#endif
+
+/**
+ * @brief picks the widest letter counting kernel the running CPU supports
+ * @return the kernel to count letters with
+ */
+CountKernel SelectCountKernel(void);
+
+/**
+ * @brief finds the length of the run of ascii bytes a block starts with
+ * @param in the bytes to check
+ * @param len number of bytes in the block
+ * @return number of ascii bytes before the first byte >= 0x80, len if all
+ * bytes are ascii
+ */
+size_t AsciiPrefix(const unsigned char *in, size_t len);
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief AsciiPrefix 16/32 bytes at a time, the caller must check the CPU
+ * supports SSE2/AVX2
+ */
+size_t AsciiPrefixSse2(const unsigned char *in, size_t len);
+size_t AsciiPrefixAvx2(const unsigned char *in, size_t len);
+#endif
+
+/**
+ * @brief picks the widest ascii run kernel the running CPU supports
+ * @return the kernel to find ascii runs with
+ */
+AsciiKernel SelectAsciiKernel(void);
+
+/**
+ * @brief validates the next bytes of a UTF-8 text, a multibyte sequence may
+ * go on in the next block. Overlong forms, surrogates and code points past
+ * U+10FFFF are invalid.
+ * @param state the validation state, is_valid set and the rest zeroed to
+ * start a text
+ * @param ascii_prefix the kernel to skip ascii runs with
+ * @param in the bytes to validate
+ * @param len number of bytes in the block
+ */
+void Utf8Update(Utf8State *state, AsciiKernel ascii_prefix,
+                const unsigned char *in, size_t len);
+
+/**
+ * @brief finds the shift a text was most likely encoded with - the shift
+ * whose decoding has the smallest chi-squared distance between its letter
+ * counts and english letter frequencies
+ * @param counts the 26 bins histogram of the encoded text
+ * @return the shift number k in [0, 26), 0 if there are no letters
+ */
+int BestShift(const unsigned long long *counts);
+
+/**
+ * @brief orders all shifts from the most to the least likely one a text was
+ * encoded with, by the chi-squared distance of their decoding to english
+ * @param counts the 26 bins histogram of the encoded text
+ * @param shifts out parameter to hold the 26 shifts in order, by shift
+ * number when there are no letters
+ */
+void RankShifts(const unsigned long long *counts, int *shifts);
+
+/**
+ * @brief crack engine - finds the shift the input was most likely encoded
+ * with from a sample of its letters, and decodes it with that shift into the
+ * output. A regular file is sampled over its whole length, a pipe by its
+ * first bytes. Errors are printed to stderr.
+ * @param input the input file to decode
+ * @param output the output file to put the decoded text
+ * @param options how the files are read and written, without a key
+ * @param shift out parameter to hold the shift that was found
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool CrackInput(FILE **input, FILE **output, const CipherOptions *options,
+                int *shift);
+
+/**
+ * @brief brute force engine - reads the input once, and decodes every block
+ * with each candidate shift into its own output file, so all candidates cost
+ * one read. Every candidate makes its own pass over the block. With top, only the most english like candidates are written,
+ * scored from a sample of the letters like CrackInput. Errors are printed to
+ * stderr.
+ * @param input the input file to decode, may be a pipe
+ * @param output_prefix the candidate of shift k is put in
+ * "<output_prefix>.<k>"
+ * @param options how the files are read and written, without a key
+ * @param top number of candidates, 0 for all BRUTE_SHIFTS of them
+ * @param shifts out parameter to hold the shifts of the candidates, from the
+ * most english like one, room for BRUTE_SHIFTS
+ * @param num_shifts out parameter to hold the number of candidates
+ * @return true on success, false if an allocation or I/O error occurred
+ */
+bool BruteInput(FILE **input, const char *output_prefix,
+                const CipherOptions *options, size_t top, int *shifts,
+                size_t *num_shifts);
+
+/**
+ * @brief reads the kernel's counters of the read and write system calls this
+ * process made so far, all threads together. Mapped file pages are not
+ * counted.
+ * @param counters out parameter to hold the counters
+ * @return true on success, false if the kernel does not provide them
+ */
+bool CipherReadIoCounters(CipherIoCounters *counters);
+
+/**
+ * @brief reads the numbers of blocks and bytes CipherUpdate transformed in
+ * this process so far, all threads together. Mapped files count as one block.
+ * @param counters out parameter to hold the counters
+ */
+void CipherReadTransformCounters(CipherTransformCounters *counters);
+
+/**
+ * @brief daemon engine - listens on a unix domain socket, only this user can
+ * connect to, and runs every connection as one job on a warm pool of worker
+ * threads with preallocated block buffers, until is_stopped is set. A job is
+ * a request line "<encode|decode> <k|key> <flags> <input path> <output
+ * path>" - flags are '-' for none, 't' for a translation table and 'v' for a
+ * vigenere key in place of k, and both paths are "-" when the input and the
+ * output are passed with the line as SCM_RIGHTS descriptors. The reply is a
+ * line "ok", or "error" and the error. Errors are printed to stderr.
+ * @param socket_path path of the socket, a socket left by a daemon that is
+ * gone is replaced
+ * @param options the daemon options, the block size and threads is the
+ * number of workers, 0 for one worker per online CPU
+ * @param is_stopped set, by a signal handler installed without SA_RESTART,
+ * to stop the daemon once the pending jobs are done
+ * @return true when stopped, false if the socket could not be set up
+ */
+bool CipherServe(const char *socket_path, const CipherOptions *options,
+                 const volatile sig_atomic_t *is_stopped);
+
+/**
+ * @brief sends a job to a running daemon and waits for its reply, the error
+ * of a failed job is printed to stderr
+ * @param socket_path path of the daemon's socket
+ * @param request the request line, ending with a new line
+ * @param input_fd the input to pass, -1 to pass no descriptors
+ * @param output_fd the output to pass, may be input_fd to transform in place
+ * @return true if the daemon ran the job, false if it failed or the daemon
+ * could not be reached
+ */
+bool CipherSubmit(const char *socket_path, const char *request, int input_fd,
+                  int output_fd);
+
+#endif //CIPHER_LIBCIPHER_H_
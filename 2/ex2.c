@@ -2,11 +2,27 @@
  * ex2.c represents a double linked list creation and process
 
 
+#define _DEFAULT_SOURCE
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include "ex2.h"
 #include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/**
+ * @brief the vectorized x86 kernels can be compiled
+ */
+#define HAS_X86_KERNELS
+#include <immintrin.h>
+#endif
 
 /**
  * @brief error message for incorrect list input
@@ -46,7 +62,8 @@
  */
 #define ERROR_FILE_NAME "ERROR: The file name is invalid.\n"
 /**
- * @brief max length of a line in a file is 1024
+ * @brief lines shorter than this are parsed in one pass, longer lines are
+ * streamed
  */
 #define MAX_LINE_LEN 1025
 /**
@@ -73,6 +90,113 @@
  * @brief new line char in linux
  */
 #define NEWLINE_LINUX "\r\n"
+/**
+ * @brief max number of grades in a line - every grade takes a digit and a
+ * comma at least
+ */
+#define MAX_LINE_GRADES (MAX_LINE_LEN / 2)
+/**
+ * @brief size of the memory of an arena block, larger carves get a block of
+ * their own
+ */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+/**
+ * @brief alignment of every carve from an arena - nodes hold pointers
+ */
+#define ARENA_ALIGN sizeof(void *)
+/**
+ * @brief number of grades in an AVX2 vector of 32 bit lanes
+ */
+#define AVX2_GRADES 8
+/**
+ * @brief number of bytes of a line an AVX2 vector compares at once
+ */
+#define AVX2_WIDTH 32
+/**
+ * @brief number of bits in a word of a comma bitmap
+ */
+#define WORD_BITS 64
+/**
+ * @brief number of words in the comma bitmap of a line, one more than a full
+ * line needs
+ */
+#define LINE_WORDS (MAX_LINE_LEN / WORD_BITS + 1)
+/**
+ * @brief base of the grades
+ */
+#define DECIMAL 10
+/**
+ * @brief a function that marks the commas of a line in a bitmap - bit i % 64
+ * of word i / 64 for byte i, the words holding no bytes of the line are 0
+ */
+typedef void (*CommaKernel)(const char *line, size_t len,
+                            unsigned long long *commas);
+/**
+ * @brief a function that sums an array of grades exactly, into 64 bits
+ */
+typedef long long (*SumKernel)(const int *grades, unsigned long len);
+/**
+ * @brief first capacity of a geometrically growing buffer
+ */
+#define INITIAL_CAPACITY 64
+/**
+ * @brief size of the buffer files are streamed through
+ */
+#define READ_BUFFER_LEN (64 * 1024)
+/**
+ * @brief error message for memory allocation error for a flat list
+ */
+#define ERROR_ALLOC_FLAT "ERROR: Memory allocation error occurred "\
+"for the flat list.\n"
+/**
+ * @brief least number of bytes of the file a parsing thread is started for
+ */
+#define MIN_THREAD_BYTES (256 * 1024)
+/**
+ * @brief max number of parsing threads
+ */
+#define MAX_PARSE_THREADS 256
+/**
+ * @brief error message for a file that could not be mapped
+ */
+#define ERROR_FILE_MAP "ERROR: The input file could not be mapped.\n"
+/**
+ * @brief error message for memory allocation error for an arena block
+ */
+#define ERROR_ALLOC_ARENA "ERROR: Memory allocation error occurred "\
+"for an arena block.\n"
+/**
+ * @brief error message for incorrect grades input
+ */
+#define ERROR_INPUT_GRADES "ERROR: The grades input is not valid.\n"
+
+/**
+ * @brief carves memory from the blocks of an arena list, freed with the list
+ * @param list the arena list to carve from
+ * @param size number of bytes to carve
+ * @return pointer to size zeroed bytes, aligned for a Node, NULL if an
+ * allocation error occurred
+ */
+void *AllocateFromArena(ArenaList *const list, size_t size) {
+  size = (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+  ArenaBlock *block = list->blocks;
+  if (block == NULL || block->capacity - block->used < size) {
+    size_t capacity = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+    block = (ArenaBlock *) malloc(sizeof(ArenaBlock) + capacity);
+    if (block == NULL) {
+      fprintf(stderr, ERROR_ALLOC_ARENA);
+      return NULL;
+    }
+    block->next = list->blocks;
+    block->used = 0;
+    block->capacity = capacity;
+    list->blocks = block;
+  }
+  void *memory = block->memory + block->used;
+  block->used += size;
+  memset(memory, 0, size);
+  return memory;
+}
 
 /**
  * Adds a node as the head of the list
@@ -139,6 +263,41 @@ void AddToEndLinkedList(LinkedList *const list, Node *const node) {
   }
 }
 
+/**
+ * @brief takes a node out of the list, without freeing it
+ * @param list the list to take the node out of
+ * @param node the node, compared to the nodes of the list with ==
+ * @return true if the node was in the list, else false
+ */
+bool UnlinkNode(LinkedList *const list, Node *const node) {
+  bool found = false;
+  Node *temp = list->head;
+  while (temp != NULL) {
+    if (temp == node) {
+      found = true;
+      break;
+    }
+    temp = temp->next;
+  }
+  if (found == false) {
+    return false;
+  }
+  // If node to be deleted is head node
+  if (list->head == node)
+    list->head = node->next;
+  if (list->tail == node)
+    list->tail = node->prev;
+  // Change next only if node to be deleted is NOT the last node
+  if (node->next != NULL)
+    node->next->prev = node->prev;
+  // Change prev only if node to be deleted is NOT the first node
+  if (node->prev != NULL)
+    node->prev->next = node->next;
+  node->next = NULL;
+  node->prev = NULL;
+  return true;
+}
+
 /**
  * removes a node from the list and frees it's resources
  *
@@ -157,7 +316,6 @@ void AddToEndLinkedList(LinkedList *const list, Node *const node) {
  * @param node pointer to the node to remove from the list
  */
 void RemoveNode(LinkedList *const list, Node *const node) {
-  bool found = false;
   if (list == NULL) {
     fprintf(stderr, ERROR_INPUT_LIST);
     return;
@@ -166,33 +324,36 @@ void RemoveNode(LinkedList *const list, Node *const node) {
     fprintf(stderr, ERROR_INPUT_NODE);
     return;
   }
-  Node *temp = list->head;
-  while (temp != NULL) {
-    if (temp == node) {
-      found = true;
-      break;
-    }
-    temp = temp->next;
-  }
-  if (found == false) {
+  if (UnlinkNode(list, node) == false) {
     return;
   }
-  // If node to be deleted is head node
-  if (list->head == node)
-    list->head = node->next;
-  if (list->tail == node)
-    list->tail = node->prev;
-  // Change next only if node to be deleted is NOT the last node
-  if (node->next != NULL)
-    node->next->prev = node->prev;
-  // Change prev only if node to be deleted is NOT the first node
-  if (node->prev != NULL)
-    node->prev->next = node->next;
   free(node->data);
   node->data = NULL;
   free(node);
 }
 
+/**
+ * @brief frees every node of a list, with its data array, and empties the
+ * list
+ * @param list the list whose nodes to free
+ */
+void FreeNodes(LinkedList *const list) {
+  Node *temp = list->head;
+  Node *next;
+  while (temp != NULL) {
+    if (temp->data != NULL) {
+      free(temp->data);
+      temp->data = NULL;
+    }
+    next = temp->next;
+    free(temp);
+    temp = NULL;
+    temp = next;
+  }
+  list->head = NULL;
+  list->tail = NULL;
+}
+
 /**
  * Frees the resources (all dynamic allocations) of the given list.
  *
@@ -211,36 +372,82 @@ void FreeLinkedList(LinkedList *const list) {
   if (list == NULL) {
     return;
   }
-  Node *temp = list->head;
-  Node *next;
-  while (temp != NULL) {
-    if (temp->data != NULL) {
-      free(temp->data);
-      temp->data = NULL;
+  FreeNodes(list);
+  free(list);
+}
+
+/**
+ * @brief calculates the sum of an array of grades into 64 bits, so rows of
+ * millions of grades do not overflow
+ * @param grades the grades to sum
+ * @param len number of grades
+ * @return the sum of the grades
+ */
+long long GetSumOfGrades(const int *grades, unsigned long len) {
+  long long sum = 0;
+  for (unsigned long i = 0; i < len; i++) {
+    sum += grades[i];
+  }
+  return sum;
+}
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief GetSumOfGrades 32 grades at a time - every 4 grades are sign
+ * extended into 64 bit lanes, and added into one of 4 accumulators so the
+ * additions do not wait on each other. The caller must check the CPU
+ * supports AVX2.
+ */
+__attribute__((target("avx2")))
+long long GetSumOfGradesAvx2(const int *grades, unsigned long len) {
+  __m256i sums[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(),
+                     _mm256_setzero_si256(), _mm256_setzero_si256()};
+  unsigned long i = 0;
+  for (; i + 4 * AVX2_GRADES <= len; i += 4 * AVX2_GRADES) {
+    for (int j = 0; j < 4; j++) {
+      const int *quads = grades + i + j * AVX2_GRADES;
+      __m256i low = _mm256_cvtepi32_epi64(
+          _mm_loadu_si128((const __m128i *) quads));
+      __m256i high = _mm256_cvtepi32_epi64(
+          _mm_loadu_si128((const __m128i *) (quads + AVX2_GRADES / 2)));
+      sums[j] = _mm256_add_epi64(sums[j], _mm256_add_epi64(low, high));
     }
-    next = temp->next;
-    free(temp);
-    temp = NULL;
-    temp = next;
   }
-  list->head = NULL;
-  list->tail = NULL;
-  free(list);
+  __m256i total = _mm256_add_epi64(_mm256_add_epi64(sums[0], sums[1]),
+                                   _mm256_add_epi64(sums[2], sums[3]));
+  long long lanes[4];
+  _mm256_storeu_si256((__m256i *) lanes, total);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+      GetSumOfGrades(grades + i, len - i);
+}
+#endif
+
+/**
+ * @brief picks the widest summing kernel the running CPU supports,
+ * GetSumOfGrades is the fallback for any other CPU
+ * @return the kernel to sum grades with
+ */
+SumKernel SelectSumKernel(void) {
+#ifdef HAS_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return GetSumOfGradesAvx2;
+  }
+#endif
+  return GetSumOfGrades;
 }
 
 /**
  * @brief calculates the sum of data array of a node in the linked list
  * @param node -the node to calculate the data sum on
+ * @param sum_kernel the kernel to sum the data array with
  * @return the sum of the data array of the node
  */
-int GetSumOfDataArr(Node *const node) {
-  int sum = 0;
-  if (node != NULL && node->data != NULL) {
-    for (unsigned long i = 0; i < node->len; i++) {
-      sum += node->data[i];
-    }
+long long GetSumOfDataArr(Node *const node, SumKernel sum_kernel) {
+  if (node == NULL || node->data == NULL) {
+    return 0;
   }
-  return sum;
+  return sum_kernel(node->data, node->len);
 }
 
 /**
@@ -284,7 +491,8 @@ double *GetAverages(LinkedList *const list,
     return NULL;
   }
   unsigned long capacity_array = 1;
-  int data_sum = 0;
+  long long data_sum = 0;
+  SumKernel sum_kernel = SelectSumKernel();
   Node *temp = list->head;
   unsigned long arr_index = 0;
   unsigned long count_averages = 0;
@@ -294,7 +502,7 @@ double *GetAverages(LinkedList *const list,
     return NULL;
   }
   while (temp != NULL) {
-    data_sum = GetSumOfDataArr(temp);
+    data_sum = GetSumOfDataArr(temp, sum_kernel);
     if (temp->len != 0) {
       count_averages++;
       if (count_averages > capacity_array) {
@@ -349,6 +557,48 @@ Node *AllocateNode() {
   return new_node;
 }
 
+/**
+ * @brief creates a node holding a copy of the grades of a line - carved from
+ * the blocks of an arena list, else allocated on its own
+ * @param arena the arena list to carve the node from, NULL to allocate it on
+ * its own
+ * @param grades the grades of the line
+ * @param num_grades number of grades, 0 for a node without data
+ * @return the new node, NULL if an allocation error occurred
+ */
+Node *CreateNode(ArenaList *arena, const int *grades,
+                 unsigned long num_grades) {
+  Node *node;
+  if (arena != NULL) {
+    node = (Node *) AllocateFromArena(arena, sizeof(Node));
+    if (node != NULL && num_grades > 0) {
+      node->data = (int *) AllocateFromArena(arena,
+                                             num_grades * sizeof(int));
+      if (node->data == NULL) {
+        return NULL;
+      }
+    }
+  } else {
+    node = AllocateNode();
+    if (node != NULL && num_grades > 0) {
+      node->data = (int *) malloc(num_grades * sizeof(int));
+      if (node->data == NULL) {
+        fprintf(stderr, ERROR_ALLOC_DATA);
+        free(node);
+        return NULL;
+      }
+    }
+  }
+  if (node == NULL) {
+    return NULL;
+  }
+  if (num_grades > 0) {
+    memcpy(node->data, grades, num_grades * sizeof(int));
+  }
+  node->len = num_grades;
+  return node;
+}
+
 /**
  * @brief creates new Linked list, allocates memory for it
  * @return the linked list that was allocated, else NULL if an error
@@ -364,121 +614,1196 @@ LinkedList *CreateList() {
 }
 
 /**
- * @brief parses line by line of the program input file
- * saves everything into the current list
- * allocates nodes and their data
- * build the Linked list correctly, by parsing each line into Node
- * then adding it to the Linked List
- * @param input the input file to parse
- * @param list the list to add the nodes to
- * @return the updated list, NULL if an memory allocation error occurred
- * frees memory allocared by it
+ * @brief marks the commas of a line in a bitmap
+ * @param line the line
+ * @param len number of bytes in the line, at most MAX_LINE_LEN - 1
+ * @param commas out parameter to hold LINE_WORDS words of bits
  */
-LinkedList *ParseFile(FILE *input, LinkedList *list) {
-  char *token;
-  char line[1025];
-  bool start = false;
-  bool end = false;
-  unsigned long capacity_tokens;
-  unsigned long data_index;
-  while (fgets(line, MAX_LINE_LEN, input) != NULL) {
-    data_index = 0;
-    capacity_tokens = 1;
-    Node *node = AllocateNode();
-    if (node == NULL) {
-      return NULL;
+void FindCommas(const char *line, size_t len, unsigned long long *commas) {
+  memset(commas, 0, (len / WORD_BITS + 1) * sizeof(*commas));
+  for (size_t i = 0; i < len; i++) {
+    if (line[i] == COMMA_DELIM[0]) {
+      commas[i / WORD_BITS] |= 1ULL << (i % WORD_BITS);
+    }
+  }
+}
+
+#ifdef HAS_X86_KERNELS
+/**
+ * @brief FindCommas 32 bytes at a time - the compare mask of a vector is
+ * the 32 bits of its bytes. The caller must check the CPU supports AVX2.
+ */
+__attribute__((target("avx2")))
+void FindCommasAvx2(const char *line, size_t len,
+                    unsigned long long *commas) {
+  memset(commas, 0, (len / WORD_BITS + 1) * sizeof(*commas));
+  const __m256i comma = _mm256_set1_epi8(COMMA_DELIM[0]);
+  size_t i = 0;
+  for (; i + AVX2_WIDTH <= len; i += AVX2_WIDTH) {
+    __m256i bytes = _mm256_loadu_si256((const __m256i *) (line + i));
+    unsigned mask = (unsigned) _mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(bytes, comma));
+    commas[i / WORD_BITS] |= (unsigned long long) mask << (i % WORD_BITS);
+  }
+  for (; i < len; i++) {
+    if (line[i] == COMMA_DELIM[0]) {
+      commas[i / WORD_BITS] |= 1ULL << (i % WORD_BITS);
     }
-    token = strtok(line, COMMA_DELIM);
-    if (strcmp(token, START_LIST) == 0) {
-      start = true;
-      end = false;
+  }
+}
+#endif
+
+/**
+ * @brief picks the widest comma finding kernel the running CPU supports,
+ * FindCommas is the fallback for any other CPU
+ * @return the kernel to find commas with
+ */
+CommaKernel SelectCommaKernel(void) {
+#ifdef HAS_X86_KERNELS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return FindCommasAvx2;
+  }
+#endif
+  return FindCommas;
+}
+
+/**
+ * @brief whether a char is white space in the C locale - space, \t, \n,
+ * \v, \f or \r
+ */
+bool IsSpace(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/**
+ * @brief adds a decimal digit to a number, clamped to a limit like strtol
+ * @param value the number
+ * @param digit the digit to add
+ * @param limit the largest magnitude of the number
+ * @return the number with the digit added, limit if it would pass it
+ */
+unsigned long AddDigit(unsigned long value, unsigned long digit,
+                       unsigned long limit) {
+  return value > (limit - digit) / DECIMAL ? limit : value * DECIMAL + digit;
+}
+
+/**
+ * @brief the largest magnitude strtol gives for a sign
+ * @param is_negative whether the number is negative
+ * @return the magnitude of LONG_MIN if negative, else LONG_MAX
+ */
+unsigned long DigitsLimit(bool is_negative) {
+  return is_negative ? (unsigned long) LONG_MAX + 1 : LONG_MAX;
+}
+
+/**
+ * @brief converts a token to a grade the way strtol does in base 10 - after
+ * leading white space, an optional sign and the digits up to the first
+ * other char, 0 without digits, clamped to the range of a long
+ * @param token the token, not null terminated
+ * @param len number of bytes in the token
+ * @return the grade
+ */
+int ParseGrade(const char *token, size_t len) {
+  size_t i = 0;
+  while (i < len && IsSpace(token[i])) {
+    i++;
+  }
+  bool is_negative = false;
+  if (i < len && (token[i] == '-' || token[i] == '+')) {
+    is_negative = token[i] == '-';
+    i++;
+  }
+  unsigned long limit = DigitsLimit(is_negative);
+  unsigned long value = 0;
+  for (; i < len && token[i] >= '0' && token[i] <= '9'; i++) {
+    value = AddDigit(value, (unsigned long) (token[i] - '0'), limit);
+  }
+  return is_negative ? (int) (long) (0UL - value) : (int) (long) value;
+}
+
+/**
+ * @brief parses a line of the input file - its first token selects whether
+ * the line and the ones after it go to the start or the end of the list, the
+ * rest are its grades, up to a token that is only a newline. Tokens are the
+ * non empty runs between commas, found in a bitmap of the commas of the line.
+ * @param line the line to parse
+ * @param len number of bytes in the line, at most MAX_LINE_LEN - 1
+ * @param find_commas the kernel to find the commas of the line with
+ * @param start whether lines go to the start of the list, updated
+ * @param end whether lines go to the end of the list, updated
+ * @param grades out parameter to hold up to MAX_LINE_GRADES grades
+ * @return number of grades in the line
+ */
+unsigned long ParseLine(const char *line, size_t len, CommaKernel find_commas,
+                        bool *start, bool *end, int *grades) {
+  unsigned long long commas[LINE_WORDS];
+  find_commas(line, len, commas);
+  unsigned long num_grades = 0;
+  bool is_first = true;
+  size_t word = 0;
+  unsigned long long bits = commas[0];
+  size_t token_begin = 0;
+  while (token_begin <= len) {
+    while (bits == 0 && (word + 1) * WORD_BITS < len) {
+      word++;
+      bits = commas[word];
     }
-    if (strcmp(token, END_LIST) == 0) {
-      end = true;
-      start = false;
+    size_t token_end = bits != 0 ? word * WORD_BITS +
+        (size_t) __builtin_ctzll(bits) : len;
+    bits &= bits - 1;
+    size_t token_len = token_end - token_begin;
+    const char *token = line + token_begin;
+    token_begin = token_end + 1;
+    if (token_len == 0) {
+      continue;
     }
-    token = strtok(NULL, COMMA_DELIM);
-    if (token != NULL && strcmp(token, NEWLINE_LINUX) != 0
-        && strcmp(token, NEWLINE_WIN) != 0) {
-      node->data = (int *) calloc(1, sizeof(int));
-      if (node->data == NULL) {
-        free(node);
-        fprintf(stderr, ERROR_ALLOC_DATA);
-        return NULL;
+    if (is_first) {
+      is_first = false;
+      if (token_len == 1 && token[0] == START_LIST[0]) {
+        *start = true;
+        *end = false;
       }
-    }
-    while (token != NULL && strcmp(token, NEWLINE_LINUX) != 0
-        && strcmp(token, NEWLINE_WIN) != 0) {
-      int grade = (int) strtol(token, NULL, 10);
-      if (node->len == capacity_tokens) {
-        capacity_tokens++;
-        int *prev_data = node->data;
-        node->data = (int *) realloc(node->data, capacity_tokens * sizeof(int));
-        if (node->data == NULL) {
-          fprintf(stderr, ERROR_ALLOC_DATA);
-          free(node);
-          node = NULL;
-          free(prev_data);
-          prev_data = NULL;
-          return NULL;
-        }
+      if (token_len == 1 && token[0] == END_LIST[0]) {
+        *end = true;
+        *start = false;
       }
-      node->data[data_index] = grade;
-      data_index++;
-      token = strtok(NULL, COMMA_DELIM);
-      node->len++;
-    }
-    if (start == true) {
-      AddToStartLinkedList(list, node);
+      continue;
     }
-    if (end == true) {
-      AddToEndLinkedList(list, node);
+    if ((token_len == strlen(NEWLINE_LINUX) &&
+        memcmp(token, NEWLINE_LINUX, token_len) == 0) ||
+        (token_len == strlen(NEWLINE_WIN) &&
+            memcmp(token, NEWLINE_WIN, token_len) == 0) ||
+        num_grades == MAX_LINE_GRADES) {
+      break;
     }
+    grades[num_grades] = ParseGrade(token, token_len);
+    num_grades++;
   }
-  return list;
+  return num_grades;
 }
 
 /**
- * opens a file from a given filename and parses it's contents into a
- * LinkedList.
- *
- * Assumptions:
-     * You cannot assume the filename is OK (meaning - you cannot assume it is
-     * a valid path to a file).
-     * You cannot assume anything on the number of ints in a row of the file,
-     * just that it is >= 1
-     * You can assume that if the file opened, then it is exactly in the format
-     * specified in the exercise PDF.
-     * You can assume max line length of 1024.
- *
- * In case of errors:
-    * Invalid pointer - print informative message to stderr, free resources
-    * allocated by function, return NULL from function.
-    * File open fail - print informative message to stderr, free resources
-    * allocated by function, return NULL from function.
-    * Allocation fail - print informative message to stderr,
-    * free resources allocated by function, return NULL from function.
- * Think - in what mode should we open this file? (read? write? append?)
- *
- * @param file filename of input file that needs to be parsed
- * @return pointer to LinkedList instance, whose nodes and data arrays were
- * parsed from the given file.
+ * @brief grows a buffer geometrically until it holds a number of items
+ * @param buffer the buffer to grow, updated
+ * @param capacity the capacity of the buffer in items, updated
+ * @param needed number of items the buffer must hold
+ * @param item_size size of an item
+ * @return true on success, false if an allocation error occurred - the
+ * buffer is kept
  */
-LinkedList *ParseLinkedList(const char *const filename) {
-  FILE *input = CheckFileInput(filename);
-  if (input == NULL) {
-    return NULL;
+bool GrowBuffer(void **buffer, size_t *capacity, size_t needed,
+                size_t item_size) {
+  if (needed <= *capacity) {
+    return true;
   }
-  LinkedList *list = CreateList();
-  if (list == NULL) {
-    fclose(input);
-    return NULL;
+  size_t new_capacity = *capacity == 0 ? INITIAL_CAPACITY : *capacity;
+  while (new_capacity < needed) {
+    new_capacity *= 2;
   }
-  if (ParseFile(input, list) == NULL) {
+  void *new_buffer = realloc(*buffer, new_capacity * item_size);
+  if (new_buffer == NULL) {
+    return false;
+  }
+  *buffer = new_buffer;
+  *capacity = new_capacity;
+  return true;
+}
+
+/**
+ * @brief the state of a line that is parsed in pieces, as ParseLine parses
+ * a whole line. A token is converted char by char the way ParseGrade does -
+ * has_sign or has_digits once the white space before its digits is over,
+ * is_done once its digits are. The grades of the line grow geometrically.
+ */
+typedef struct LineScan {
+  bool is_first;
+  size_t token_len;
+  char token_head[2];
+  bool has_sign;
+  bool has_digits;
+  bool is_done;
+  bool is_negative;
+  unsigned long value;
+  int *grades;
+  size_t capacity;
+  unsigned long num_grades;
+} LineScan;
+
+/**
+ * @brief starts the next token of a line scan
+ * @param scan the line scan
+ */
+void StartToken(LineScan *scan) {
+  scan->token_len = 0;
+  scan->has_sign = false;
+  scan->has_digits = false;
+  scan->is_done = false;
+  scan->is_negative = false;
+  scan->value = 0;
+}
+
+/**
+ * @brief starts a line scan of the next line, its grade buffer is kept
+ * @param scan the line scan
+ */
+void StartLineScan(LineScan *scan) {
+  scan->is_first = true;
+  scan->num_grades = 0;
+  StartToken(scan);
+}
+
+/**
+ * @brief adds a char to the token of a line scan
+ * @param scan the line scan
+ * @param c the char, not a comma
+ */
+void ScanTokenChar(LineScan *scan, char c) {
+  if (scan->token_len < sizeof(scan->token_head)) {
+    scan->token_head[scan->token_len] = c;
+  }
+  scan->token_len++;
+  if (scan->is_done) {
+    return;
+  }
+  if (c >= '0' && c <= '9') {
+    scan->has_digits = true;
+    scan->value = AddDigit(scan->value, (unsigned long) (c - '0'),
+                           DigitsLimit(scan->is_negative));
+  } else if (scan->has_digits == false && scan->has_sign == false
+      && (c == '-' || c == '+')) {
+    scan->has_sign = true;
+    scan->is_negative = c == '-';
+  } else if (scan->has_digits || scan->has_sign || IsSpace(c) == false) {
+    scan->is_done = true;
+  }
+}
+
+/**
+ * @brief ends the token of a line scan - the first token of the line
+ * selects the start or the end of the list, the others are grades, but for
+ * a token that is only a newline
+ * @param scan the line scan
+ * @param start whether lines go to the start of the list, updated
+ * @param end whether lines go to the end of the list, updated
+ * @return true on success, false if an allocation error occurred
+ */
+bool EndToken(LineScan *scan, bool *start, bool *end) {
+  if (scan->token_len == 0) {
+    return true;
+  }
+  size_t len = scan->token_len;
+  const char *head = scan->token_head;
+  if (scan->is_first) {
+    scan->is_first = false;
+    if (len == 1 && head[0] == START_LIST[0]) {
+      *start = true;
+      *end = false;
+    }
+    if (len == 1 && head[0] == END_LIST[0]) {
+      *end = true;
+      *start = false;
+    }
+  } else if ((len == 1 && head[0] == NEWLINE_WIN[0]) == false
+      && (len == 2 && memcmp(head, NEWLINE_LINUX, len) == 0) == false) {
+    if (GrowBuffer((void **) &scan->grades, &scan->capacity,
+                   scan->num_grades + 1, sizeof(int)) == false) {
+      fprintf(stderr, ERROR_ALLOC_DATA);
+      return false;
+    }
+    scan->grades[scan->num_grades] = scan->is_negative ?
+        (int) (long) (0UL - scan->value) : (int) (long) scan->value;
+    scan->num_grades++;
+  }
+  StartToken(scan);
+  return true;
+}
+
+/**
+ * @brief scans the next piece of a line
+ * @param scan the line scan
+ * @param bytes the piece, a newline may only be its last byte
+ * @param len number of bytes in the piece
+ * @param start whether lines go to the start of the list, updated
+ * @param end whether lines go to the end of the list, updated
+ * @return true on success, false if an allocation error occurred
+ */
+bool ScanLineBytes(LineScan *scan, const char *bytes, size_t len, bool *start,
+                   bool *end) {
+  for (size_t i = 0; i < len; i++) {
+    if (bytes[i] != COMMA_DELIM[0]) {
+      ScanTokenChar(scan, bytes[i]);
+    } else if (EndToken(scan, start, end) == false) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief the buffer a file is streamed through, line by line. A line of up
+ * to MAX_LINE_LEN - 1 bytes is parsed in one pass into short_grades, a
+ * longer one is streamed through scan, so the memory used does not depend on
+ * the length of the lines.
+ */
+typedef struct LineReader {
+  FILE *input;
+  char *buffer;
+  size_t position;
+  size_t length;
+  bool is_eof;
+  bool is_valid;
+  CommaKernel find_commas;
+  int short_grades[MAX_LINE_GRADES];
+  LineScan scan;
+} LineReader;
+
+/**
+ * @brief starts a line reader of a file
+ * @param reader the line reader
+ * @param input the file to read
+ * @return true on success, false if an allocation error occurred
+ */
+bool OpenLineReader(LineReader *reader, FILE *input) {
+  memset(reader, 0, sizeof(*reader));
+  reader->input = input;
+  reader->is_valid = true;
+  reader->find_commas = SelectCommaKernel();
+  reader->buffer = (char *) malloc(READ_BUFFER_LEN);
+  if (reader->buffer == NULL) {
+    fprintf(stderr, ERROR_ALLOC_DATA);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief frees the buffers of a line reader
+ * @param reader the line reader
+ */
+void CloseLineReader(LineReader *reader) {
+  free(reader->buffer);
+  reader->buffer = NULL;
+  free(reader->scan.grades);
+  reader->scan.grades = NULL;
+}
+
+/**
+ * @brief reads more of the file, after the bytes still unread, until the
+ * buffer is full or the file ends
+ * @param reader the line reader
+ */
+void FillLineReader(LineReader *reader) {
+  size_t left = reader->length - reader->position;
+  memmove(reader->buffer, reader->buffer + reader->position, left);
+  reader->position = 0;
+  reader->length = left;
+  while (reader->is_eof == false && reader->length < READ_BUFFER_LEN) {
+    size_t read_len = fread(reader->buffer + reader->length, 1,
+                            READ_BUFFER_LEN - reader->length, reader->input);
+    reader->length += read_len;
+    reader->is_eof = read_len == 0;
+  }
+}
+
+/**
+ * @brief streams a line longer than MAX_LINE_LEN - 1 bytes through the
+ * buffer into the line scan
+ * @param reader the line reader, its position at the line
+ * @param start whether lines go to the start of the list, updated
+ * @param end whether lines go to the end of the list, updated
+ * @return true on success, false if an allocation error occurred
+ */
+bool StreamLongLine(LineReader *reader, bool *start, bool *end) {
+  StartLineScan(&reader->scan);
+  while (reader->position < reader->length) {
+    const char *bytes = reader->buffer + reader->position;
+    size_t left = reader->length - reader->position;
+    const char *newline = (const char *) memchr(bytes, '\n', left);
+    size_t len = newline != NULL ? (size_t) (newline - bytes) + 1 : left;
+    if (ScanLineBytes(&reader->scan, bytes, len, start, end) == false) {
+      return false;
+    }
+    reader->position += len;
+    if (newline != NULL) {
+      break;
+    }
+    FillLineReader(reader);
+  }
+  return EndToken(&reader->scan, start, end);
+}
+
+/**
+ * @brief reads and parses the next line of the file
+ * @param reader the line reader
+ * @param start whether lines go to the start of the list, updated
+ * @param end whether lines go to the end of the list, updated
+ * @param grades out parameter to point at the grades of the line, valid
+ * until the next line is read
+ * @param num_grades out parameter to hold the number of grades in the line
+ * @return true if a line was read, false at the end of the file or if an
+ * allocation error occurred - is_valid is false then
+ */
+bool ReadLine(LineReader *reader, bool *start, bool *end, const int **grades,
+              unsigned long *num_grades) {
+  if (reader->length - reader->position < MAX_LINE_LEN - 1) {
+    FillLineReader(reader);
+  }
+  const char *line = reader->buffer + reader->position;
+  size_t left = reader->length - reader->position;
+  if (left == 0) {
+    return false;
+  }
+  size_t max_len = left < MAX_LINE_LEN - 1 ? left : MAX_LINE_LEN - 1;
+  const char *newline = (const char *) memchr(line, '\n', max_len);
+  if (newline == NULL && left > MAX_LINE_LEN - 1) {
+    reader->is_valid = StreamLongLine(reader, start, end);
+    *grades = reader->scan.grades;
+    *num_grades = reader->scan.num_grades;
+    return reader->is_valid;
+  }
+  size_t len = newline != NULL ? (size_t) (newline - line) + 1 : left;
+  *num_grades = ParseLine(line, len, reader->find_commas, start, end,
+                          reader->short_grades);
+  *grades = reader->short_grades;
+  reader->position += len;
+  return true;
+}
+
+/**
+ * @brief parses line by line of the program input file
+ * saves everything into the current list
+ * allocates nodes and their data
+ * build the Linked list correctly, by parsing each line into Node
+ * then adding it to the Linked List
+ * @param input the input file to parse
+ * @param list the list to add the nodes to
+ * @param arena the arena list to carve the nodes from, its own list, NULL to
+ * allocate every node on its own
+ * @return the updated list, NULL if an memory allocation error occurred
+ * frees memory allocared by it
+ */
+LinkedList *ParseFile(FILE *input, LinkedList *list, ArenaList *arena) {
+  LineReader reader;
+  const int *grades;
+  bool start = false;
+  bool end = false;
+  unsigned long num_grades;
+  LinkedList *result = list;
+  if (OpenLineReader(&reader, input) == false) {
+    result = NULL;
+  }
+  // The grades are gathered first, so the data array is allocated once
+  while (result != NULL
+      && ReadLine(&reader, &start, &end, &grades, &num_grades)) {
+    // A line that belongs to no list makes no node
+    if (start == false && end == false) {
+      continue;
+    }
+    Node *node = CreateNode(arena, grades, num_grades);
+    if (node == NULL) {
+      result = NULL;
+      break;
+    }
+    if (start == true) {
+      AddToStartLinkedList(list, node);
+    }
+    if (end == true) {
+      AddToEndLinkedList(list, node);
+    }
+  }
+  if (reader.is_valid == false) {
+    result = NULL;
+  }
+  CloseLineReader(&reader);
+  return result;
+}
+
+/**
+ * opens a file from a given filename and parses it's contents into a
+ * LinkedList.
+ *
+ * Assumptions:
+     * You cannot assume the filename is OK (meaning - you cannot assume it is
+     * a valid path to a file).
+     * You cannot assume anything on the number of ints in a row of the file,
+     * just that it is >= 1
+     * You can assume that if the file opened, then it is exactly in the format
+     * specified in the exercise PDF.
+     * Lines may be of any length, a long line is never split.
+ *
+ * In case of errors:
+    * Invalid pointer - print informative message to stderr, free resources
+    * allocated by function, return NULL from function.
+    * File open fail - print informative message to stderr, free resources
+    * allocated by function, return NULL from function.
+    * Allocation fail - print informative message to stderr,
+    * free resources allocated by function, return NULL from function.
+ * Think - in what mode should we open this file? (read? write? append?)
+ *
+ * @param file filename of input file that needs to be parsed
+ * @return pointer to LinkedList instance, whose nodes and data arrays were
+ * parsed from the given file.
+ */
+LinkedList *ParseLinkedList(const char *const filename) {
+  FILE *input = CheckFileInput(filename);
+  if (input == NULL) {
+    return NULL;
+  }
+  LinkedList *list = CreateList();
+  if (list == NULL) {
+    fclose(input);
+    return NULL;
+  }
+  if (ParseFile(input, list, NULL) == NULL) {
     FreeLinkedList(list);
     fclose(input);
     return NULL;
   }
   fclose(input);
   return list;
+}
+
+/**
+ * parses a file like ParseLinkedList into an arena list - the nodes and their
+ * data arrays are carved from large blocks owned by the list, so parsing
+ * makes one allocation per block instead of per node, and FreeArenaList
+ * frees the blocks instead of every node.
+ *
+ * In case of errors:
+    * As ParseLinkedList.
+ *
+ * @param filename filename of input file that needs to be parsed
+ * @return pointer to ArenaList instance, NULL on error
+ */
+ArenaList *ParseArenaList(const char *const filename) {
+  FILE *input = CheckFileInput(filename);
+  if (input == NULL) {
+    return NULL;
+  }
+  ArenaList *list = (ArenaList *) calloc(1, sizeof(ArenaList));
+  if (list == NULL) {
+    fprintf(stderr, ERROR_ALLOC_LIST);
+    fclose(input);
+    return NULL;
+  }
+  if (ParseFile(input, &list->list, list) == NULL) {
+    FreeArenaList(list);
+    fclose(input);
+    return NULL;
+  }
+  fclose(input);
+  return list;
+}
+
+/**
+ * @brief creates a node in the blocks of an arena list, holding a copy of
+ * the given grades
+ * @param list the arena list
+ * @param grades the grades of the node
+ * @param len number of grades, 0 for a node without data
+ * @return the new node, NULL on error
+ */
+Node *CreateArenaNode(ArenaList *const list, const int *grades,
+                      unsigned long len) {
+  if (list == NULL) {
+    fprintf(stderr, ERROR_INPUT_LIST);
+    return NULL;
+  }
+  if (grades == NULL && len > 0) {
+    fprintf(stderr, ERROR_INPUT_GRADES);
+    return NULL;
+  }
+  return CreateNode(list, grades, len);
+}
+
+/**
+ * creates a node holding a copy of the given grades in the blocks of an
+ * arena list, and adds it as the head of the list
+ *
+ * In case of errors:
+    * Invalid pointer - print informative message to stderr, return NULL.
+    * Allocation fail - print informative message to stderr, return NULL.
+ *
+ * @param list the arena list to add a node to
+ * @param grades the grades of the node, NULL if len is 0
+ * @param len number of grades, 0 for a node without data
+ * @return the new node, NULL on error
+ */
+Node *AddToStartArenaList(ArenaList *const list, const int *grades,
+                          unsigned long len) {
+  Node *node = CreateArenaNode(list, grades, len);
+  if (node != NULL) {
+    AddToStartLinkedList(&list->list, node);
+  }
+  return node;
+}
+
+/**
+ * creates a node holding a copy of the given grades in the blocks of an
+ * arena list, and adds it as the tail of the list
+ *
+ * In case of errors:
+    * As AddToStartArenaList.
+ *
+ * @param list the arena list to add a node to
+ * @param grades the grades of the node, NULL if len is 0
+ * @param len number of grades, 0 for a node without data
+ * @return the new node, NULL on error
+ */
+Node *AddToEndArenaList(ArenaList *const list, const int *grades,
+                        unsigned long len) {
+  Node *node = CreateArenaNode(list, grades, len);
+  if (node != NULL) {
+    AddToEndLinkedList(&list->list, node);
+  }
+  return node;
+}
+
+/**
+ * removes a node from an arena list - its memory stays in the blocks of the
+ * list until the list is freed
+ *
+ * Assumptions:
+    * As RemoveNode.
+ *
+ * In case of errors:
+    * As RemoveNode.
+ *
+ * @param list pointer to arena list to remove a node from
+ * @param node pointer to the node to remove from the list
+ */
+void RemoveArenaNode(ArenaList *const list, Node *const node) {
+  if (list == NULL) {
+    fprintf(stderr, ERROR_INPUT_LIST);
+    return;
+  }
+  if (node == NULL) {
+    fprintf(stderr, ERROR_INPUT_NODE);
+    return;
+  }
+  UnlinkNode(&list->list, node);
+}
+
+/**
+ * Frees the given arena list, with every block its nodes and data arrays
+ * were carved from.
+ *
+ * In case of errors:
+    * Invalid pointer - nothing to free, just return from function.
+ *
+ * @param list the arena list to free.
+ */
+void FreeArenaList(ArenaList *const list) {
+  if (list == NULL) {
+    return;
+  }
+  ArenaBlock *block = list->blocks;
+  while (block != NULL) {
+    ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  free(list);
+}
+
+/**
+ * @brief lays the lines of a file, read in file order, out in list order -
+ * the lines that went to the start of the list are reversed before the
+ * others, and their grades are copied into one buffer in that order
+ * @param list the flat list to fill
+ * @param grades the grades of all lines in file order
+ * @param lines the lines in file order, offsets into grades
+ * @param at_start whether every line went to the start of the list
+ * @param num_lines number of lines
+ * @param num_grades number of grades
+ * @return the filled list, NULL if an allocation error occurred
+ */
+FlatList *OrderFlatList(FlatList *list, const int *grades,
+                        const FlatNode *lines, const bool *at_start,
+                        size_t num_lines, size_t num_grades) {
+  size_t num_start = 0;
+  for (size_t i = 0; i < num_lines; i++) {
+    num_start += at_start[i] ? 1 : 0;
+  }
+  list->nodes = (FlatNode *) malloc((num_lines + 1) * sizeof(FlatNode));
+  list->grades = (int *) malloc((num_grades + 1) * sizeof(int));
+  if (list->nodes == NULL || list->grades == NULL) {
+    fprintf(stderr, ERROR_ALLOC_FLAT);
+    return NULL;
+  }
+  size_t start_index = num_start;
+  size_t end_index = num_start;
+  for (size_t i = 0; i < num_lines; i++) {
+    size_t index = at_start[i] ? --start_index : end_index++;
+    list->nodes[index] = lines[i];
+  }
+  size_t offset = 0;
+  for (size_t i = 0; i < num_lines; i++) {
+    FlatNode *node = &list->nodes[i];
+    if (node->len > 0) {
+      memcpy(list->grades + offset, grades + node->offset,
+             node->len * sizeof(int));
+    }
+    node->offset = offset;
+    offset += node->len;
+  }
+  list->num_nodes = num_lines;
+  list->num_grades = num_grades;
+  return list;
+}
+
+/**
+ * @brief parses line by line of the program input file into a flat list -
+ * the lines are gathered in file order, then laid out in list order
+ * @param input the input file to parse
+ * @param list the flat list to fill
+ * @return the filled list, NULL if an allocation error occurred
+ */
+FlatList *ParseFlatFile(FILE *input, FlatList *list) {
+  LineReader reader;
+  const int *line_grades;
+  unsigned long len;
+  bool start = false;
+  bool end = false;
+  int *grades = NULL;
+  FlatNode *lines = NULL;
+  bool *at_start = NULL;
+  size_t grades_capacity = 0;
+  size_t lines_capacity = 0;
+  size_t starts_capacity = 0;
+  size_t num_grades = 0;
+  size_t num_lines = 0;
+  FlatList *result = list;
+  if (OpenLineReader(&reader, input) == false) {
+    result = NULL;
+  }
+  while (result != NULL
+      && ReadLine(&reader, &start, &end, &line_grades, &len)) {
+    if (start == false && end == false) {
+      continue;
+    }
+    if (GrowBuffer((void **) &grades, &grades_capacity, num_grades + len,
+                   sizeof(int)) == false
+        || GrowBuffer((void **) &lines, &lines_capacity, num_lines + 1,
+                      sizeof(FlatNode)) == false
+        || GrowBuffer((void **) &at_start, &starts_capacity, num_lines + 1,
+                      sizeof(bool)) == false) {
+      fprintf(stderr, ERROR_ALLOC_FLAT);
+      result = NULL;
+      break;
+    }
+    if (len > 0) {
+      memcpy(grades + num_grades, line_grades, len * sizeof(int));
+    }
+    lines[num_lines].offset = num_grades;
+    lines[num_lines].len = len;
+    at_start[num_lines] = start;
+    num_grades += len;
+    num_lines++;
+  }
+  if (reader.is_valid == false) {
+    result = NULL;
+  }
+  CloseLineReader(&reader);
+  if (result != NULL) {
+    result = OrderFlatList(list, grades, lines, at_start, num_lines,
+                           num_grades);
+  }
+  free(grades);
+  free(lines);
+  free(at_start);
+  return result;
+}
+
+/**
+ * opens a file from a given filename and parses it's contents into a
+ * FlatList, in the same order as ParseLinkedList.
+ *
+ * In case of errors:
+    * As ParseLinkedList.
+ *
+ * @param filename filename of input file that needs to be parsed
+ * @return pointer to FlatList instance, NULL on error
+ */
+FlatList *ParseFlatList(const char *const filename) {
+  FILE *input = CheckFileInput(filename);
+  if (input == NULL) {
+    return NULL;
+  }
+  FlatList *list = (FlatList *) calloc(1, sizeof(FlatList));
+  if (list == NULL) {
+    fprintf(stderr, ERROR_ALLOC_FLAT);
+    fclose(input);
+    return NULL;
+  }
+  if (ParseFlatFile(input, list) == NULL) {
+    FreeFlatList(list);
+    fclose(input);
+    return NULL;
+  }
+  fclose(input);
+  return list;
+}
+
+/**
+ * copies the nodes of a linked list into a FlatList, in list order.
+ *
+ * In case of errors:
+    * Invalid pointer - print informative message to stderr, return NULL.
+    * Allocation fail - print informative message to stderr, free resources
+    * allocated by function, return NULL.
+ *
+ * @param list the linked list to copy
+ * @return pointer to FlatList instance, NULL on error
+ */
+FlatList *FlattenLinkedList(LinkedList *const list) {
+  if (list == NULL) {
+    fprintf(stderr, ERROR_INPUT_LIST);
+    return NULL;
+  }
+  size_t num_nodes = 0;
+  size_t num_grades = 0;
+  for (Node *temp = list->head; temp != NULL; temp = temp->next) {
+    num_nodes++;
+    num_grades += temp->data != NULL ? temp->len : 0;
+  }
+  FlatList *flat = (FlatList *) calloc(1, sizeof(FlatList));
+  if (flat == NULL) {
+    fprintf(stderr, ERROR_ALLOC_FLAT);
+    return NULL;
+  }
+  flat->nodes = (FlatNode *) malloc((num_nodes + 1) * sizeof(FlatNode));
+  flat->grades = (int *) malloc((num_grades + 1) * sizeof(int));
+  if (flat->nodes == NULL || flat->grades == NULL) {
+    fprintf(stderr, ERROR_ALLOC_FLAT);
+    FreeFlatList(flat);
+    return NULL;
+  }
+  size_t index = 0;
+  size_t offset = 0;
+  for (Node *temp = list->head; temp != NULL; temp = temp->next) {
+    unsigned long len = temp->data != NULL ? temp->len : 0;
+    if (len > 0) {
+      memcpy(flat->grades + offset, temp->data, len * sizeof(int));
+    }
+    flat->nodes[index].offset = offset;
+    flat->nodes[index].len = len;
+    offset += len;
+    index++;
+  }
+  flat->num_nodes = num_nodes;
+  flat->num_grades = num_grades;
+  return flat;
+}
+
+/**
+ * calculates the grade average of every node in the flat list, like
+ * GetAverages, in one linear pass over its grades.
+ *
+ * In case of errors:
+    * As GetAverages.
+ *
+ * @param list the flat list
+ * @param num_elements_in_returned_array out parameter to hold the number of
+ * nodes with data
+ * @return array of grade averages per node with data, NULL on error
+ */
+double *GetFlatAverages(const FlatList *const list,
+                        size_t *const num_elements_in_returned_array) {
+  if (list == NULL) {
+    fprintf(stderr, ERROR_INPUT_LIST);
+    return NULL;
+  }
+  if (num_elements_in_returned_array == NULL) {
+    fprintf(stderr, ERROR_NUM_ELEM);
+    return NULL;
+  }
+  double *average_arr = (double *) malloc((list->num_nodes + 1) *
+                                          sizeof(double));
+  if (average_arr == NULL) {
+    fprintf(stderr, ERROR_ALLOC_ARR);
+    return NULL;
+  }
+  size_t count_averages = 0;
+  SumKernel sum_kernel = SelectSumKernel();
+  for (size_t i = 0; i < list->num_nodes; i++) {
+    const FlatNode *node = &list->nodes[i];
+    if (node->len != 0) {
+      long long data_sum = sum_kernel(list->grades + node->offset, node->len);
+      average_arr[count_averages] = (double) data_sum / (double) node->len;
+      count_averages++;
+    }
+  }
+  *num_elements_in_returned_array = count_averages;
+  return average_arr;
+}
+
+/**
+ * Frees the resources of the given flat list.
+ *
+ * In case of errors:
+    * Invalid pointer - nothing to free, just return from function.
+ *
+ * @param list the flat list to free.
+ */
+void FreeFlatList(FlatList *const list) {
+  if (list == NULL) {
+    return;
+  }
+  free(list->grades);
+  free(list->nodes);
+  free(list);
+}
+
+/**
+ * @brief the range of whole lines of a mapped file a thread parses, and the
+ * chains of nodes it parses them into. pending holds, in file order, the
+ * nodes of the lines before the first start or end marker of the range,
+ * which go where the ranges before leave the state. starts holds the nodes
+ * that go to the start of the list, in list order, and ends the ones that go
+ * to its end.
+ */
+typedef struct ParseJob {
+  const char *begin;
+  const char *end;
+  LinkedList pending;
+  LinkedList starts;
+  LinkedList ends;
+  CommaKernel find_commas;
+  LineScan scan;
+  bool is_start;
+  bool is_end;
+  bool is_valid;
+} ParseJob;
+
+/**
+ * @brief parses the lines of a range into its chains, where they are mapped
+ * - a line of up to MAX_LINE_LEN - 1 bytes in one pass, a longer one through
+ * the line scan of the range
+ * @param arg the ParseJob of the range
+ * @return NULL
+ */
+void *ParseRange(void *arg) {
+  ParseJob *job = (ParseJob *) arg;
+  int short_grades[MAX_LINE_GRADES];
+  const int *grades = short_grades;
+  unsigned long num_grades;
+  const char *position = job->begin;
+  while (position < job->end) {
+    size_t left = (size_t) (job->end - position);
+    const char *newline = (const char *) memchr(position, '\n', left);
+    size_t len = newline != NULL ? (size_t) (newline - position) + 1 : left;
+    if (len <= MAX_LINE_LEN - 1) {
+      num_grades = ParseLine(position, len, job->find_commas, &job->is_start,
+                             &job->is_end, short_grades);
+      grades = short_grades;
+    } else {
+      StartLineScan(&job->scan);
+      if (ScanLineBytes(&job->scan, position, len, &job->is_start,
+                        &job->is_end) == false
+          || EndToken(&job->scan, &job->is_start, &job->is_end) == false) {
+        job->is_valid = false;
+        return NULL;
+      }
+      num_grades = job->scan.num_grades;
+      grades = job->scan.grades;
+    }
+    position += len;
+    // The chain of a line before any marker is only known after the join
+    LinkedList *chain = &job->pending;
+    if (job->is_start || job->is_end) {
+      chain = job->is_start ? &job->starts : &job->ends;
+    }
+    Node *node = CreateNode(NULL, grades, num_grades);
+    if (node == NULL) {
+      job->is_valid = false;
+      return NULL;
+    }
+    if (chain == &job->starts) {
+      AddToStartLinkedList(chain, node);
+    } else {
+      AddToEndLinkedList(chain, node);
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief moves all nodes of a chain to the start or the end of a list, in
+ * their order, and empties the chain
+ * @param list the list to move the nodes to
+ * @param chain the chain of nodes to move
+ * @param at_start true to move them to the start of the list, false to the
+ * end
+ */
+void SpliceLinkedList(LinkedList *const list, LinkedList *const chain,
+                      bool at_start) {
+  if (chain->head == NULL) {
+    return;
+  }
+  if (list->head == NULL) {
+    list->head = chain->head;
+    list->tail = chain->tail;
+  } else if (at_start) {
+    chain->tail->next = list->head;
+    list->head->prev = chain->tail;
+    list->head = chain->head;
+  } else {
+    list->tail->next = chain->head;
+    chain->head->prev = list->tail;
+    list->tail = chain->tail;
+  }
+  chain->head = NULL;
+  chain->tail = NULL;
+}
+
+/**
+ * @brief joins the chains of the parsed ranges into the list in file order -
+ * the pending nodes of a range follow the last marker of the ranges before
+ * it, nodes before any marker in the file are not part of the list
+ * @param list the list to join the chains into
+ * @param jobs the parsed ranges, in file order, their chains emptied
+ * @param num_jobs number of ranges
+ */
+void JoinRanges(LinkedList *const list, ParseJob *jobs, size_t num_jobs) {
+  bool is_start = false;
+  bool is_end = false;
+  for (size_t i = 0; i < num_jobs; i++) {
+    if (is_start) {
+      while (jobs[i].pending.head != NULL) {
+        Node *node = jobs[i].pending.head;
+        jobs[i].pending.head = node->next;
+        node->next = NULL;
+        node->prev = NULL;
+        AddToStartLinkedList(list, node);
+      }
+      jobs[i].pending.tail = NULL;
+    } else if (is_end) {
+      SpliceLinkedList(list, &jobs[i].pending, false);
+    } else {
+      FreeNodes(&jobs[i].pending);
+    }
+    SpliceLinkedList(list, &jobs[i].starts, true);
+    SpliceLinkedList(list, &jobs[i].ends, false);
+    if (jobs[i].is_start || jobs[i].is_end) {
+      is_start = jobs[i].is_start;
+      is_end = jobs[i].is_end;
+    }
+  }
+}
+
+/**
+ * @brief splits a mapped file into ranges of whole lines, parses them on
+ * their own threads, and joins their chains into the list
+ * @param text the mapped file
+ * @param size size of the file
+ * @param num_threads the number of threads asked for, 0 for one per online
+ * CPU
+ * @param list the list to add the nodes to
+ * @return the updated list, NULL if an allocation error occurred
+ */
+LinkedList *ParseMappedFile(const char *text, size_t size,
+                            unsigned long num_threads, LinkedList *list) {
+  if (num_threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = online > 0 ? (unsigned long) online : 1;
+  }
+  size_t num_jobs = size / MIN_THREAD_BYTES + 1;
+  num_jobs = num_jobs < num_threads ? num_jobs : num_threads;
+  num_jobs = num_jobs < MAX_PARSE_THREADS ? num_jobs : MAX_PARSE_THREADS;
+  ParseJob jobs[MAX_PARSE_THREADS];
+  pthread_t threads[MAX_PARSE_THREADS];
+  bool is_started[MAX_PARSE_THREADS];
+  const char *begin = text;
+  for (size_t i = 0; i < num_jobs; i++) {
+    // A range ends after the newline of its last line
+    const char *end = text + size / num_jobs * (i + 1);
+    end = end > begin ? end - 1 : begin;
+    const char *newline = (const char *) memchr(end, '\n',
+                                                (size_t) (text + size - end));
+    end = i == num_jobs - 1 || newline == NULL ? text + size : newline + 1;
+    memset(&jobs[i], 0, sizeof(jobs[i]));
+    jobs[i].begin = begin;
+    jobs[i].end = end;
+    jobs[i].find_commas = SelectCommaKernel();
+    jobs[i].is_valid = true;
+    begin = end;
+  }
+  for (size_t i = 0; i < num_jobs; i++) {
+    is_started[i] = pthread_create(&threads[i], NULL, ParseRange,
+                                   &jobs[i]) == 0;
+    if (is_started[i] == false) {
+      // No thread left for this range, parse it here
+      ParseRange(&jobs[i]);
+    }
+  }
+  bool is_valid = true;
+  for (size_t i = 0; i < num_jobs; i++) {
+    if (is_started[i]) {
+      pthread_join(threads[i], NULL);
+    }
+    is_valid = is_valid && jobs[i].is_valid;
+    free(jobs[i].scan.grades);
+  }
+  if (is_valid == false) {
+    for (size_t i = 0; i < num_jobs; i++) {
+      FreeNodes(&jobs[i].pending);
+      FreeNodes(&jobs[i].starts);
+      FreeNodes(&jobs[i].ends);
+    }
+    return NULL;
+  }
+  JoinRanges(list, jobs, num_jobs);
+  return list;
+}
+
+/**
+ * parses a file like ParseLinkedList, on several threads - the file is
+ * mapped, split into one range of whole lines per thread, every range is
+ * parsed into chains of nodes on its own thread, and the chains are joined
+ * in file order, so the list is exactly the one ParseLinkedList gives.
+ *
+ * In case of errors:
+    * As ParseLinkedList.
+ *
+ * @param filename filename of input file that needs to be parsed
+ * @param num_threads number of threads, 0 for one per online CPU - small
+ * files use fewer
+ * @return pointer to LinkedList instance, NULL on error
+ */
+LinkedList *ParseLinkedListThreaded(const char *const filename,
+                                    unsigned long num_threads) {
+  FILE *input = CheckFileInput(filename);
+  if (input == NULL) {
+    return NULL;
+  }
+  struct stat file_stat;
+  if (fstat(fileno(input), &file_stat) != 0) {
+    fprintf(stderr, ERROR_FILE_OPEN);
+    fclose(input);
+    return NULL;
+  }
+  LinkedList *list = CreateList();
+  if (list == NULL || file_stat.st_size == 0) {
+    fclose(input);
+    return list;
+  }
+  size_t size = (size_t) file_stat.st_size;
+  void *text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(input), 0);
+  fclose(input);
+  if (text == MAP_FAILED) {
+    fprintf(stderr, ERROR_FILE_MAP);
+    FreeLinkedList(list);
+    return NULL;
+  }
+  madvise(text, size, MADV_SEQUENTIAL);
+  if (ParseMappedFile((const char *) text, size, num_threads, list) == NULL) {
+    munmap(text, size);
+    FreeLinkedList(list);
+    return NULL;
+  }
+  munmap(text, size);
+  return list;
 }
\ No newline at end of file
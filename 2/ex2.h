@@ -25,6 +25,17 @@ typedef struct Node {
   unsigned long len;
 } Node;
 
+/**
+ * @brief a large block of memory that the nodes and data arrays of an arena
+ * list are carved from, blocks are chained from the newest one
+ */
+typedef struct ArenaBlock {
+  struct ArenaBlock *next;
+  size_t used;
+  size_t capacity;
+  unsigned char memory[];
+} ArenaBlock;
+
 /**
  * @brief represents a double sided list
  */
@@ -33,6 +44,37 @@ typedef struct LinkedList {
   Node *tail;
 } LinkedList;
 
+/**
+ * @brief a double sided list whose nodes and data arrays are carved from
+ * blocks owned by the list, instead of allocated one by one. list may be
+ * read by every function that reads a LinkedList, and is changed only by
+ * the ArenaList functions.
+ */
+typedef struct ArenaList {
+  LinkedList list;
+  ArenaBlock *blocks;
+} ArenaList;
+
+/**
+ * @brief the grades of a node of a flat list - len grades from offset in the
+ * grades buffer of the list, len is 0 for a node without data
+ */
+typedef struct FlatNode {
+  size_t offset;
+  unsigned long len;
+} FlatNode;
+
+/**
+ * @brief represents a list whose grades are stored in one contiguous buffer
+ * in list order - nodes[0] is the head and nodes[num_nodes - 1] the tail
+ */
+typedef struct FlatList {
+  int *grades;
+  size_t num_grades;
+  FlatNode *nodes;
+  size_t num_nodes;
+} FlatList;
+
 /**
  * Adds a node as the head of the list
  * Assumptions:
@@ -142,7 +184,7 @@ num_elements_in_returned_array);
      * just that it is >= 1
      * You can assume that if the file opened, then it is exactly in the format
      * specified in the exercise PDF.
-     * You can assume max line length of 1024.
+     * Lines may be of any length, a long line is never split.
  *
  * In case of errors:
     * Invalid pointer - print informative message to stderr, free resources
@@ -162,4 +204,151 @@ num_elements_in_returned_array);
  */
 LinkedList *ParseLinkedList(const char *const filename);
 
+/**
+ * parses a file like ParseLinkedList into an arena list - the nodes and their
+ * data arrays are carved from large blocks owned by the list, so parsing
+ * makes one allocation per block instead of per node, and FreeArenaList
+ * frees the blocks instead of every node.
+ *
+ * Assumptions:
+     * As ParseLinkedList.
+ *
+ * In case of errors:
+    * As ParseLinkedList.
+ *
+ * @param filename filename of input file that needs to be parsed
+ * @return pointer to ArenaList instance, NULL on error
+ */
+ArenaList *ParseArenaList(const char *const filename);
+
+/**
+ * opens a file from a given filename and parses it's contents into a
+ * FlatList, in the same order as ParseLinkedList.
+ *
+ * Assumptions:
+     * As ParseLinkedList.
+ *
+ * In case of errors:
+    * As ParseLinkedList.
+ *
+ * @param filename filename of input file that needs to be parsed
+ * @return pointer to FlatList instance, NULL on error
+ */
+FlatList *ParseFlatList(const char *const filename);
+
+/**
+ * parses a file like ParseLinkedList, on several threads - the file is
+ * mapped, split into one range of whole lines per thread, every range is
+ * parsed into chains of nodes on its own thread, and the chains are joined
+ * in file order, so the list is exactly the one ParseLinkedList gives.
+ *
+ * Assumptions:
+     * As ParseLinkedList.
+ *
+ * In case of errors:
+    * As ParseLinkedList.
+ *
+ * @param filename filename of input file that needs to be parsed
+ * @param num_threads number of threads, 0 for one per online CPU - small
+ * files use fewer
+ * @return pointer to LinkedList instance, NULL on error
+ */
+LinkedList *ParseLinkedListThreaded(const char *const filename,
+                                    unsigned long num_threads);
+
+/**
+ * copies the nodes of a linked list into a FlatList, in list order.
+ *
+ * In case of errors:
+    * Invalid pointer - print informative message to stderr, return NULL.
+    * Allocation fail - print informative message to stderr, free resources
+    * allocated by function, return NULL.
+ *
+ * @param list the linked list to copy
+ * @return pointer to FlatList instance, NULL on error
+ */
+FlatList *FlattenLinkedList(LinkedList *const list);
+
+/**
+ * calculates the grade average of every node in the flat list, like
+ * GetAverages, in one linear pass over its grades.
+ *
+ * In case of errors:
+    * As GetAverages.
+ *
+ * @param list the flat list
+ * @param num_elements_in_returned_array out parameter to hold the number of
+ * nodes with data
+ * @return array of grade averages per node with data, NULL on error
+ */
+double *GetFlatAverages(const FlatList *const list,
+                        size_t *const num_elements_in_returned_array);
+
+/**
+ * Frees the resources of the given flat list.
+ *
+ * In case of errors:
+    * Invalid pointer - nothing to free, just return from function.
+ *
+ * @param list the flat list to free.
+ */
+void FreeFlatList(FlatList *const list);
+
+/**
+ * creates a node holding a copy of the given grades in the blocks of an
+ * arena list, and adds it as the head of the list
+ *
+ * In case of errors:
+    * Invalid pointer - print informative message to stderr, return NULL.
+    * Allocation fail - print informative message to stderr, return NULL.
+ *
+ * @param list the arena list to add a node to
+ * @param grades the grades of the node, NULL if len is 0
+ * @param len number of grades, 0 for a node without data
+ * @return the new node, NULL on error
+ */
+Node *AddToStartArenaList(ArenaList *const list, const int *grades,
+                          unsigned long len);
+
+/**
+ * creates a node holding a copy of the given grades in the blocks of an
+ * arena list, and adds it as the tail of the list
+ *
+ * In case of errors:
+    * As AddToStartArenaList.
+ *
+ * @param list the arena list to add a node to
+ * @param grades the grades of the node, NULL if len is 0
+ * @param len number of grades, 0 for a node without data
+ * @return the new node, NULL on error
+ */
+Node *AddToEndArenaList(ArenaList *const list, const int *grades,
+                        unsigned long len);
+
+/**
+ * removes a node from an arena list - its memory stays in the blocks of the
+ * list until the list is freed
+ *
+ * Assumptions:
+    * As RemoveNode.
+ *
+ * In case of errors:
+    * As RemoveNode.
+ *
+ * @param list pointer to arena list to remove a node from
+ * @param node pointer to the node to remove from the list
+ */
+void RemoveArenaNode(ArenaList *const list, Node *const node);
+
+/**
+ * Frees the given arena list, with every block its nodes and data arrays
+ * were carved from.
+ *
+ * In case of errors:
+    * Invalid pointer - nothing to free, just return from function.
+ *
+ * @param list the arena list to free.
+ */
+void FreeArenaList(ArenaList *const list);
+
 #endif //EX2_WINTER2020_EX2_H_
\ No newline at end of file